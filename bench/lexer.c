@@ -0,0 +1,149 @@
+/*
+ * Copyright 2025 Frank Mitchell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Times the lexer on long strings and long comments of doubling size.
+ * If lexing is linear, the time per byte stays roughly flat.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "elexer.h"
+
+#define MIN_SIZE    (1 << 20)
+#define MAX_SIZE    (64 << 20)
+#define REPEAT      3
+
+/*
+ * How much the cost per byte may grow from the smallest input to the
+ * largest before we call it nonlinear; generous, since timings are noisy.
+ */
+#define MAX_SLOWDOWN 4.0
+
+typedef struct Text_Source {
+    const char8_t* text;
+    size_t len;
+    size_t span;
+} Text_Source;
+
+static ssize_t Text_Source_next_span(void* state, size_t release,
+                                     size_t offset, const char8_t** spanptr) {
+    Text_Source* self = (Text_Source *) state;
+    size_t left;
+
+    self->text += release;
+    self->len -= release;
+    left = self->len - offset;
+    if (left == 0) {
+        return 0;
+    }
+    (*spanptr) = self->text + offset;
+    return (left < self->span) ? left : self->span;
+}
+
+static double now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+ * A long string or comment of `size` bytes, with a few near-miss closing
+ * brackets and line breaks every so often.
+ */
+static char* make_text(size_t size, bool comment) {
+    const char* open = comment ? "--[==[" : "[==[";
+    const char* filler = "lorem ipsum ]=] dolor ]] sit amet\n";
+    const size_t openlen = strlen(open);
+    const size_t fillerlen = strlen(filler);
+    char* text = malloc(size + 1);
+    size_t i;
+
+    memcpy(text, open, openlen);
+    for (i = openlen; i < size - 4; i++) {
+        text[i] = filler[(i - openlen) % fillerlen];
+    }
+    memcpy(text + size - 4, "]==]", 4);
+    text[size] = '\0';
+    return text;
+}
+
+static double time_text(const char* text, size_t size, ELTN_Token expect) {
+    double best = 0;
+
+    for (int i = 0; i < REPEAT; i++) {
+        Text_Source source = { (const char8_t *)text, size, 64 * 1024 };
+        ELTN_Lexer* lexer = ELTN_Lexer_new_with_pool(NULL);
+        ELTN_Token token;
+        double start, elapsed;
+
+        ELTN_Lexer_set_span_source(lexer, Text_Source_next_span, &source);
+        start = now();
+        token = ELTN_Lexer_next_token(lexer, NULL, NULL);
+        elapsed = now() - start;
+        ELTN_Lexer_free(lexer);
+
+        if (token != expect) {
+            fprintf(stderr, "unexpected token %d\n", (int)token);
+            exit(2);
+        }
+        if (i == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+    return best;
+}
+
+static bool bench(const char* name, bool comment, ELTN_Token expect) {
+    double first = 0;
+    double per_byte = 0;
+
+    printf("%s\n", name);
+    for (size_t size = MIN_SIZE; size <= MAX_SIZE; size *= 2) {
+        char* text = make_text(size, comment);
+        double elapsed = time_text(text, size, expect);
+
+        free(text);
+        per_byte = elapsed * 1e9 / size;
+        if (size == MIN_SIZE) {
+            first = per_byte;
+        }
+        printf("  %6zu MiB  %9.3f ms  %6.3f ns/byte\n",
+               size >> 20, elapsed * 1e3, per_byte);
+    }
+    if (per_byte > first * MAX_SLOWDOWN) {
+        printf("  NONLINEAR: %.1fx slower per byte\n", per_byte / first);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    bool ok = true;
+
+    ok = bench("long string", false, ELTN_TOKEN_LONG_STRING) && ok;
+    ok = bench("long comment", true, ELTN_TOKEN_LONG_COMMENT) && ok;
+    return ok ? 0 : 1;
+}
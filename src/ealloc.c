@@ -129,6 +129,17 @@ void ELTN_new_string(char** strptr, size_t* lenptr,
     (*lenptr) = srclen;
 }
 
+void ELTN_new_string_in_pool(ELTN_Pool* h, char** strptr, size_t* lenptr,
+                             const char* srcstr, size_t srclen) {
+    char* dest = (char *)ELTN_alloc(h, srclen + 1);
+
+    if (dest != NULL && srclen > 0) {
+        memcpy(dest, srcstr, srclen);
+    }
+    (*strptr) = dest;
+    (*lenptr) = (dest != NULL) ? srclen : 0;
+}
+
 void ELTN_free_string(char* str) {
     free(str);
 }
@@ -49,6 +49,13 @@ void ELTN_free(ELTN_Pool * h, void* ptr);
 void ELTN_new_string(char** strptr, size_t* lenptr, const char* srcstr,
                      size_t srclen);
 
+/**
+ * Create a copy of a string using the pool's allocator, to be freed with
+ * ELTN_free().  `*strptr` is NULL if out of memory.
+ */
+void ELTN_new_string_in_pool(ELTN_Pool * h, char** strptr, size_t* lenptr,
+                             const char* srcstr, size_t srclen);
+
 /**
  * Free a string using the default allocator.
  */
@@ -22,9 +22,17 @@
  *
  ****************************************************************************/
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE 1           /* for memfd_create() */
+#endif
+
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <wchar.h>
+#ifndef ELTN_NO_THREADS
+#include <pthread.h>
+#endif
 
 #define ELTN_CORE 1
 #include "eltn.h"
@@ -32,6 +40,12 @@
 #include "convert.h"
 #include "ealloc.h"
 
+#if defined(__linux__) && !defined(ELTN_NO_POSIX) && !defined(ELTN_NO_MIRROR)
+#define ELTN_MIRROR 1
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 #define INIT_BUF_SIZE 1024
 
 /**************************** ELTN_Buffer ***********************************/
@@ -43,18 +57,223 @@ struct ELTN_Buffer {
     void* reader_state;
 
     char8_t* buffer;
-    int bufsize;
+    size_t bufsize;
+    bool mirrored;              /* buffer mapped twice, back to back */
+    size_t maxsize;             /* 0 if unlimited */
     char8_t* head;
     char8_t* tail;
     bool eof;
+    ELTN_Error errcode;         /* why the buffer stopped reading early */
+
+    /*
+     * Caller-owned text read in place instead of the ring buffer.
+     */
+    const char8_t* borrowed;
+    const char8_t* borrowed_end;
+
+    /*
+     * Source of borrowed chunks, and how to return the current one.
+     */
+    ELTN_Lender lender;
+    void* lender_state;
+    const char8_t* lent;
+    size_t lent_size;
+    ELTN_Release release;
+
+    /*
+     * Bytes handed out by ELTN_Buffer_next_span() and not yet released,
+     * and the ring they lie in if a resize replaced it meanwhile.
+     */
+    size_t spanned;
+    bool span_in_ring;
+    char8_t* retired;
+    size_t retired_size;
+
+    ELTN_Buffer_Cleanup cleanup;
+    void* cleanup_state;
+
+    /*
+     * Producer/consumer synchronization
+     */
+    bool synchronized;
+#ifndef ELTN_NO_THREADS
+    bool lock_ready;
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+#endif
 };
 
+static void lock(ELTN_Buffer* self) {
+#ifndef ELTN_NO_THREADS
+    if (self->synchronized) {
+        pthread_mutex_lock(&(self->lock));
+    }
+#endif
+}
+
+static void unlock(ELTN_Buffer* self) {
+#ifndef ELTN_NO_THREADS
+    if (self->synchronized) {
+        pthread_mutex_unlock(&(self->lock));
+    }
+#endif
+}
+
+static void wait_until_not_empty(ELTN_Buffer* self) {
+#ifndef ELTN_NO_THREADS
+    pthread_cond_wait(&(self->not_empty), &(self->lock));
+#endif
+}
+
+/*
+ * Wait for the parser to make room, until `deadline` if not NULL.
+ * Returns false if the deadline passed (or there is nothing to wait on).
+ */
+static bool wait_until_not_full(ELTN_Buffer* self,
+                                const struct timespec* deadline) {
+#ifndef ELTN_NO_THREADS
+    if (!self->synchronized) {
+        return false;
+    }
+    if (deadline == NULL) {
+        pthread_cond_wait(&(self->not_full), &(self->lock));
+        return true;
+    }
+    return pthread_cond_timedwait(&(self->not_full), &(self->lock),
+                                  deadline) == 0;
+#else
+    return false;
+#endif
+}
+
+static void signal_not_empty(ELTN_Buffer* self) {
+#ifndef ELTN_NO_THREADS
+    if (self->synchronized) {
+        pthread_cond_broadcast(&(self->not_empty));
+    }
+#endif
+}
+
+static void signal_not_full(ELTN_Buffer* self) {
+#ifndef ELTN_NO_THREADS
+    if (self->synchronized) {
+        pthread_cond_broadcast(&(self->not_full));
+    }
+#endif
+}
+
+static void release_lent(ELTN_Buffer* self) {
+    if (self->lent != NULL && self->release != NULL) {
+        self->release(self->lender_state, (const char *)self->lent,
+                      self->lent_size);
+    }
+    if (self->lent != NULL) {
+        self->borrowed = NULL;
+        self->borrowed_end = NULL;
+    }
+    self->lent = NULL;
+    self->lent_size = 0;
+    self->release = NULL;
+}
+
+#ifdef ELTN_MIRROR
+static size_t page_size(void) {
+    long result = sysconf(_SC_PAGESIZE);
+
+    return (result > 0) ? (size_t)result : 4096;
+}
+
+/*
+ * Map `size` bytes of anonymous memory twice, back to back, so that a
+ * ring read or written past its end continues at its start.
+ */
+static char8_t* mirror_alloc(size_t size) {
+    char8_t* addr;
+    int fd = memfd_create("eltn-buffer", MFD_CLOEXEC);
+
+    if (fd < 0) {
+        return NULL;
+    }
+    if (ftruncate(fd, size) != 0) {
+        close(fd);
+        return NULL;
+    }
+    addr = mmap(NULL, 2 * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (addr == MAP_FAILED) {
+        close(fd);
+        return NULL;
+    }
+    if (mmap(addr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+             fd, 0) == MAP_FAILED
+        || mmap(addr + size, size, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(addr, 2 * size);
+        close(fd);
+        return NULL;
+    }
+    close(fd);
+    return addr;
+}
+#endif
+
+static char8_t* ring_alloc(ELTN_Buffer* self, size_t size) {
+#ifdef ELTN_MIRROR
+    if (self->mirrored) {
+        return mirror_alloc(size);
+    }
+#endif
+    return (char8_t *) ELTN_alloc(self->pool, size);
+}
+
+static void ring_free(ELTN_Buffer* self, char8_t* buf, size_t size) {
+#ifdef ELTN_MIRROR
+    if (self->mirrored) {
+        munmap(buf, 2 * size);
+        return;
+    }
+#endif
+    ELTN_free(self->pool, buf);
+}
+
+/*
+ * A mirrored ring must be a whole number of pages, no larger than the
+ * maximum capacity.  Returns 0 if no such size exists.
+ */
+static size_t ring_size(ELTN_Buffer* self, size_t size) {
+#ifdef ELTN_MIRROR
+    if (self->mirrored) {
+        const size_t page = page_size();
+
+        size = (size + page - 1) / page * page;
+        if (self->maxsize > 0 && size > self->maxsize) {
+            size -= page;
+        }
+    }
+#endif
+    return size;
+}
+
 void ELTN_Buffer_free(ELTN_Buffer* self) {
     ELTN_Pool* h = self->pool;
 
+    release_lent(self);
+    if (self->cleanup != NULL) {
+        self->cleanup(self->cleanup_state);
+    }
     if (self->buffer != NULL) {
-        ELTN_free(h, self->buffer);
+        ring_free(self, self->buffer, self->bufsize);
+    }
+    if (self->retired != NULL) {
+        ring_free(self, self->retired, self->retired_size);
+    }
+#ifndef ELTN_NO_THREADS
+    if (self->lock_ready) {
+        pthread_cond_destroy(&(self->not_full));
+        pthread_cond_destroy(&(self->not_empty));
+        pthread_mutex_destroy(&(self->lock));
     }
+#endif
     ELTN_free(h, self);
     ELTN_Pool_release(&h);
 }
@@ -69,21 +288,39 @@ ELTN_Buffer* ELTN_Buffer_new_with_pool(ELTN_Pool* pool) {
     result->pool = pool;
     ELTN_Pool_acquire(&(result->pool));
 
+    /*
+     * The ring itself is allocated on the first write, so a buffer that
+     * only ever reads borrowed text never allocates one.
+     */
     result->bufsize = INIT_BUF_SIZE;
-    result->buffer = (char8_t *) ELTN_alloc(pool, result->bufsize);
-    if (result->buffer == NULL) {
-        ELTN_Buffer_free(result);
-        return NULL;
-    }
-    memset(result->buffer, 0, INIT_BUF_SIZE);
-    result->head = result->buffer;
-    result->tail = result->buffer;
+    result->buffer = NULL;
+    result->head = NULL;
+    result->tail = NULL;
     result->eof = false;
 
     return result;
 }
 
-size_t ELTN_Buffer_length(ELTN_Buffer* self) {
+static bool ensure_ring(ELTN_Buffer* self) {
+    if (self->buffer != NULL) {
+        return true;
+    }
+    self->buffer = ring_alloc(self, self->bufsize);
+    if (self->buffer == NULL) {
+        return false;
+    }
+    self->head = self->buffer;
+    self->tail = self->buffer;
+    return true;
+}
+
+void ELTN_Buffer_set_cleanup(ELTN_Buffer* self, ELTN_Buffer_Cleanup fcn,
+                             void* state) {
+    self->cleanup = fcn;
+    self->cleanup_state = state;
+}
+
+static size_t ring_length(ELTN_Buffer* self) {
     if (self->head <= self->tail) {
         return self->tail - self->head;
     } else {
@@ -91,18 +328,64 @@ size_t ELTN_Buffer_length(ELTN_Buffer* self) {
     }
 }
 
+static size_t buffer_length(ELTN_Buffer* self) {
+    if (self->borrowed != NULL) {
+        return self->borrowed_end - self->borrowed;
+    }
+    return ring_length(self);
+}
+
+size_t ELTN_Buffer_length(ELTN_Buffer* self) {
+    size_t result;
+
+    lock(self);
+    result = buffer_length(self);
+    unlock(self);
+    return result;
+}
+
 ELTN_API size_t ELTN_Buffer_capacity(ELTN_Buffer* self) {
-    return self->bufsize;
+    size_t result;
+
+    lock(self);
+    result = self->bufsize;
+    unlock(self);
+    return result;
 }
 
-ELTN_API bool ELTN_Buffer_set_capacity(ELTN_Buffer* self, size_t newcap) {
-    const size_t length = ELTN_Buffer_length(self);
+/*
+ * Free the old ring after a resize, unless the lexer still holds a span
+ * of it; then keep it until the lexer asks for its next span.
+ */
+static void retire_ring(ELTN_Buffer* self, char8_t* oldbuf, size_t oldsize) {
+    if (self->spanned > 0 && self->span_in_ring && self->retired == NULL) {
+        self->retired = oldbuf;
+        self->retired_size = oldsize;
+    } else {
+        ring_free(self, oldbuf, oldsize);
+    }
+}
+
+static void free_retired(ELTN_Buffer* self) {
+    if (self->retired != NULL) {
+        ring_free(self, self->retired, self->retired_size);
+        self->retired = NULL;
+        self->retired_size = 0;
+    }
+}
+
+static bool resize_ring(ELTN_Buffer* self, size_t newcap) {
+    const size_t length = ring_length(self);
 
+    if (self->maxsize > 0 && newcap > self->maxsize) {
+        return false;
+    }
+    newcap = ring_size(self, newcap);
     if (newcap <= length) {
         return false;
     }
 
-    if (length == 0) {
+    if (length == 0 && !self->mirrored) {
         char8_t* newbuf =
             (char8_t *) ELTN_realloc(self->pool, self->buffer, newcap);
 
@@ -113,13 +396,15 @@ ELTN_API bool ELTN_Buffer_set_capacity(ELTN_Buffer* self, size_t newcap) {
         self->head = newbuf;
         self->tail = newbuf;
         self->bufsize = newcap;
+    } else if (self->buffer == NULL) {
+        self->bufsize = newcap;
     } else {
-        char8_t* newbuf = (char8_t *) ELTN_alloc(self->pool, newcap);
+        char8_t* newbuf = ring_alloc(self, newcap);
 
         if (newbuf == NULL) {
             return false;
         }
-        if (self->head < self->tail) {
+        if (self->mirrored || self->head <= self->tail) {
             memcpy(newbuf, self->head, length);
         } else {
             size_t taillen = self->tail - self->buffer;
@@ -128,7 +413,7 @@ ELTN_API bool ELTN_Buffer_set_capacity(ELTN_Buffer* self, size_t newcap) {
             memcpy(newbuf, self->head, headlen);
             memcpy(newbuf + headlen, self->buffer, taillen);
         }
-        ELTN_free(self->pool, self->buffer);
+        retire_ring(self, self->buffer, self->bufsize);
         self->buffer = newbuf;
         self->head = newbuf;
         self->tail = newbuf + length;
@@ -137,12 +422,233 @@ ELTN_API bool ELTN_Buffer_set_capacity(ELTN_Buffer* self, size_t newcap) {
     return true;
 }
 
+ELTN_API bool ELTN_Buffer_set_capacity(ELTN_Buffer* self, size_t newcap) {
+    bool result;
+
+    lock(self);
+    result = resize_ring(self, newcap);
+    if (result) {
+        signal_not_full(self);
+    }
+    unlock(self);
+    return result;
+}
+
+ELTN_API size_t ELTN_Buffer_max_capacity(ELTN_Buffer* self) {
+    return self->maxsize;
+}
+
+ELTN_API bool ELTN_Buffer_set_max_capacity(ELTN_Buffer* self, size_t maxcap) {
+    bool result = true;
+    size_t oldmax;
+
+    if (maxcap == 1) {
+        return false;
+    }
+
+    lock(self);
+    oldmax = self->maxsize;
+    self->maxsize = maxcap;
+    if (maxcap > 0 && maxcap < self->bufsize) {
+        result = resize_ring(self, maxcap);
+    }
+    if (!result) {
+        self->maxsize = oldmax;
+    }
+    unlock(self);
+    return result;
+}
+
+ELTN_API bool ELTN_Buffer_is_mirrored(ELTN_Buffer* self) {
+    return self->mirrored;
+}
+
+ELTN_API bool ELTN_Buffer_set_mirrored(ELTN_Buffer* self, bool b) {
+#ifdef ELTN_MIRROR
+    bool result = true;
+
+    lock(self);
+    if (b != self->mirrored) {
+        if (ring_length(self) > 0) {
+            result = false;
+        } else {
+            free_retired(self);
+            if (self->buffer != NULL) {
+                ring_free(self, self->buffer, self->bufsize);
+                self->buffer = NULL;
+                self->head = NULL;
+                self->tail = NULL;
+            }
+            self->mirrored = b;
+            if (ring_size(self, self->bufsize) == 0) {
+                self->mirrored = !b;
+                result = false;
+            } else {
+                self->bufsize = ring_size(self, self->bufsize);
+            }
+        }
+    }
+    unlock(self);
+    return result;
+#else
+    return !b;
+#endif
+}
+
+ELTN_API bool ELTN_Buffer_is_synchronized(ELTN_Buffer* self) {
+    return self->synchronized;
+}
+
+ELTN_API bool ELTN_Buffer_set_synchronized(ELTN_Buffer* self, bool b) {
+#ifndef ELTN_NO_THREADS
+    if (b && !self->lock_ready) {
+        if (pthread_mutex_init(&(self->lock), NULL) != 0) {
+            return false;
+        }
+        if (pthread_cond_init(&(self->not_empty), NULL) != 0) {
+            pthread_mutex_destroy(&(self->lock));
+            return false;
+        }
+        if (pthread_cond_init(&(self->not_full), NULL) != 0) {
+            pthread_cond_destroy(&(self->not_empty));
+            pthread_mutex_destroy(&(self->lock));
+            return false;
+        }
+        self->lock_ready = true;
+    }
+    self->synchronized = b;
+    return true;
+#else
+    return !b;
+#endif
+}
+
+bool ELTN_Buffer_is_lent(ELTN_Buffer* self) {
+    return self->lender != NULL;
+}
+
+ELTN_Error ELTN_Buffer_error(ELTN_Buffer* self) {
+    return self->errcode;
+}
+
 ELTN_API bool ELTN_Buffer_is_empty(ELTN_Buffer* self) {
-    return self->head == self->tail;
+    return ELTN_Buffer_length(self) == 0;
 }
 
 ELTN_API bool ELTN_Buffer_is_closed(ELTN_Buffer* self) {
-    return self->eof;
+    bool result;
+
+    lock(self);
+    result = self->eof;
+    unlock(self);
+    return result;
+}
+
+/*
+ * Bytes the ring can accept without growing; one byte always stays free
+ * so that a full ring is distinguishable from an empty one.
+ */
+static size_t ring_room(ELTN_Buffer* self) {
+    return self->bufsize - ring_length(self) - 1;
+}
+
+static void copy_into_ring(ELTN_Buffer* self, const char* text, size_t len) {
+#ifdef ELTN_MIRROR
+    if (self->mirrored) {
+        memcpy(self->tail, text, len);
+        self->tail = self->buffer + (self->tail - self->buffer + len) % self->bufsize;
+        return;
+    }
+#endif
+    if (self->tail + len < self->buffer + self->bufsize) {
+        memmove(self->tail, text, len);
+        self->tail += len;
+    } else {
+        size_t headlen = self->buffer + self->bufsize - self->tail;
+        size_t taillen = len - headlen;
+
+        memmove(self->tail, text, headlen);
+        memmove(self->buffer, text + headlen, taillen);
+        self->tail = self->buffer + taillen;
+    }
+}
+
+/*
+ * Grow the ring towards twice what it needs to hold, short of its
+ * maximum capacity.
+ */
+static void grow_ring(ELTN_Buffer* self, size_t needed) {
+    size_t newcap = needed * 2;
+
+    if (self->maxsize > 0 && newcap > self->maxsize) {
+        newcap = self->maxsize;
+    }
+    if (newcap > self->bufsize) {
+        resize_ring(self, newcap);
+    }
+}
+
+static ssize_t write_all(ELTN_Buffer* self, const char* text, size_t len) {
+    if (self->eof || !ensure_ring(self)) {
+        return -1;
+    }
+    if (len > ring_room(self)) {
+        grow_ring(self, ring_length(self) + len + 1);
+        if (len > ring_room(self)) {
+            return -1;
+        }
+    }
+    copy_into_ring(self, text, len);
+    signal_not_empty(self);
+    return len;
+}
+
+/*
+ * Write as much of `text` as fits without growing past the maximum
+ * capacity.  Returns the bytes written, or -1 if the buffer is closed.
+ */
+static ssize_t write_partial(ELTN_Buffer* self, const char* text, size_t len) {
+    size_t chunk = len;
+
+    if (self->eof || !ensure_ring(self)) {
+        return -1;
+    }
+    if (chunk > ring_room(self)) {
+        grow_ring(self, ring_length(self) + chunk + 1);
+    }
+    if (chunk > ring_room(self)) {
+        chunk = ring_room(self);
+    }
+    if (chunk > 0) {
+        copy_into_ring(self, text, chunk);
+        signal_not_empty(self);
+    }
+    return chunk;
+}
+
+/*
+ * Write `text` piece by piece, waiting for room until `deadline` if not
+ * NULL or until the buffer closes.
+ */
+static ssize_t write_waiting(ELTN_Buffer* self, const char* text, size_t len,
+                             const struct timespec* deadline) {
+    size_t written = 0;
+
+    if (self->eof || !ensure_ring(self)) {
+        return -1;
+    }
+    while (written < len && !self->eof) {
+        ssize_t chunk = write_partial(self, text + written, len - written);
+
+        if (chunk < 0) {
+            break;
+        }
+        written += chunk;
+        if (written < len && !wait_until_not_full(self, deadline)) {
+            break;
+        }
+    }
+    return (written > 0 || !self->eof) ? (ssize_t) written : -1;
 }
 
 static ssize_t read_into_buffer(ELTN_Buffer* self, bool first) {
@@ -162,7 +668,7 @@ static ssize_t read_into_buffer(ELTN_Buffer* self, bool first) {
          */
     }
 
-    writeresult = ELTN_Buffer_write(self, text, readsize);
+    writeresult = write_all(self, text, readsize);
     free(text);
 
     if (errcode != 0) {
@@ -171,6 +677,12 @@ static ssize_t read_into_buffer(ELTN_Buffer* self, bool first) {
     }
 
     if (writeresult < 0) {
+        if (self->buffer != NULL && self->maxsize > 0
+            && ring_length(self) + readsize >= self->maxsize) {
+            self->errcode = ELTN_ERR_LIMIT_EXCEEDED;
+        } else {
+            self->errcode = ELTN_ERR_OUT_OF_MEMORY;
+        }
         self->eof = true;
         return writeresult;
     }
@@ -178,51 +690,159 @@ static ssize_t read_into_buffer(ELTN_Buffer* self, bool first) {
     return readsize;
 }
 
+/*
+ * Return the current lent chunk, if any, and borrow the next.
+ */
+static ssize_t lend_into_buffer(ELTN_Buffer* self) {
+    const char* text = NULL;
+    size_t size = 0;
+    ELTN_Release release = NULL;
+    int errcode;
+
+    release_lent(self);
+    errcode = self->lender(self->lender_state, &text, &size, &release);
+
+    if (text == NULL || errcode != 0) {
+        if (text != NULL && release != NULL) {
+            release(self->lender_state, text, size);
+        }
+        if (errcode != 0) {
+            self->errcode = ELTN_ERR_READ;
+        }
+        self->eof = true;
+        return -1;
+    }
+
+    self->lent = (const char8_t *)text;
+    self->lent_size = size;
+    self->release = release;
+    self->borrowed = self->lent;
+    self->borrowed_end = self->lent + size;
+    return size;
+}
+
+ssize_t ELTN_Buffer_read_lent(ELTN_Buffer* self, ELTN_Lender lender,
+                              void* lender_state) {
+    ssize_t result = -1;
+
+    if (!lender) {
+        return -1;
+    }
+
+    lock(self);
+    if (!self->eof && self->reader == NULL && self->lender == NULL
+        && buffer_length(self) == 0) {
+        self->lender = lender;
+        self->lender_state = lender_state;
+        result = lend_into_buffer(self);
+        signal_not_empty(self);
+    }
+    unlock(self);
+    return result;
+}
+
 ssize_t ELTN_Buffer_read(ELTN_Buffer* self, ELTN_Reader reader,
                          void* reader_state) {
+    ssize_t result;
+
     if (!reader) {
         return -1;
     }
 
+    lock(self);
     self->reader = reader;
     self->reader_state = reader_state;
 
-    return read_into_buffer(self, true);
+    result = read_into_buffer(self, true);
+    unlock(self);
+    return result;
 }
 
 ELTN_API ssize_t ELTN_Buffer_write(ELTN_Buffer* self, const char* text,
                                    size_t len) {
-    const size_t currlen = ELTN_Buffer_length(self);
+    ssize_t result;
 
-    if (self->eof) {
-        return -1;
+    lock(self);
+    if (self->synchronized) {
+        result = write_waiting(self, text, len, NULL);
+    } else {
+        result = write_all(self, text, len);
     }
-    if (currlen + len >= ELTN_Buffer_capacity(self)) {
-        bool status = ELTN_Buffer_set_capacity(self, (currlen + len) * 2);
+    unlock(self);
+    return result;
+}
 
-        if (!status) {
-            return -1;
-        }
+ELTN_API ssize_t ELTN_Buffer_write_nb(ELTN_Buffer* self, const char* text,
+                                      size_t len) {
+    ssize_t result;
+
+    lock(self);
+    result = write_partial(self, text, len);
+    unlock(self);
+    return result;
+}
+
+ELTN_API ssize_t ELTN_Buffer_write_timed(ELTN_Buffer* self, const char* text,
+                                         size_t len, long timeout_ms) {
+    struct timespec deadline;
+    ssize_t result;
+
+    if (timeout_ms <= 0) {
+        return ELTN_Buffer_write_nb(self, text, len);
     }
-    if (self->tail + len < self->buffer + self->bufsize) {
-        memmove(self->tail, text, len);
-        self->tail += len;
-    } else {
-        size_t headlen = self->buffer + self->bufsize - self->tail;
-        size_t taillen = len - headlen;
 
-        memmove(self->tail, text, headlen);
-        memmove(self->buffer, text + headlen, taillen);
-        self->tail = self->buffer + taillen;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec += 1;
+        deadline.tv_nsec -= 1000000000L;
     }
-    return len;
+
+    lock(self);
+    result = write_waiting(self, text, len, &deadline);
+    unlock(self);
+    return result;
+}
+
+ELTN_API ssize_t ELTN_Buffer_borrow(ELTN_Buffer* self, const char* text,
+                                    size_t len) {
+    ssize_t result = -1;
+
+    lock(self);
+    if (!self->eof && self->reader == NULL && self->lender == NULL
+        && buffer_length(self) == 0
+        && (text != NULL || len == 0)) {
+        self->borrowed = (const char8_t *)text;
+        self->borrowed_end = (const char8_t *)text + len;
+        self->eof = true;
+        result = len;
+        signal_not_empty(self);
+    }
+    unlock(self);
+    return result;
 }
 
 ELTN_API void ELTN_Buffer_close(ELTN_Buffer* self) {
+    lock(self);
     self->eof = true;
+    signal_not_empty(self);
+    signal_not_full(self);
+    unlock(self);
 }
 
 static int32_t next_byte(ELTN_Buffer* self, bool consume) {
+    if (self->borrowed != NULL) {
+        if (self->borrowed == self->borrowed_end) {
+            return -1;
+        }
+        char8_t c = *(self->borrowed);
+
+        if (consume) {
+            self->borrowed++;
+        }
+        return c;
+    }
     if (self->head == self->tail) {
         return -1;
     }
@@ -233,21 +853,34 @@ static int32_t next_byte(ELTN_Buffer* self, bool consume) {
         if (self->head >= self->buffer + self->bufsize) {
             self->head = self->buffer;
         }
+        signal_not_full(self);
     }
     return c;
 }
 
-static bool ensure_more_bytes(ELTN_Buffer* self) {
-    if (self->eof) {
-        return false;
-    }
-
-    if (self->reader == NULL) {
-        return false;
-    }
-
-    while (ELTN_Buffer_length(self) == 0) {
-        if (read_into_buffer(self, false) < 0) {
+/*
+ * Make sure at least `wanted` unreleased bytes are on hand.
+ */
+static bool ensure_more_bytes(ELTN_Buffer* self, size_t wanted) {
+    while (buffer_length(self) < wanted) {
+        if (self->eof) {
+            return false;
+        }
+        if (self->lender != NULL) {
+            /*
+             * A lent chunk is returned whole, so only when all of it
+             * has been released.
+             */
+            if (buffer_length(self) > 0 || lend_into_buffer(self) < 0) {
+                return false;
+            }
+        } else if (self->reader != NULL) {
+            if (read_into_buffer(self, false) < 0) {
+                return false;
+            }
+        } else if (self->synchronized) {
+            wait_until_not_empty(self);
+        } else {
             return false;
         }
     }
@@ -256,12 +889,66 @@ static bool ensure_more_bytes(ELTN_Buffer* self) {
 
 int32_t ELTN_Buffer_next_char(void* state, bool consume) {
     ELTN_Buffer* self = (ELTN_Buffer *) state;
+    int32_t result = -1;
 
-    if (self->head == self->tail) {
-        if (!ensure_more_bytes(self)) {
-            return -1;
-        }
+    lock(self);
+    if (ensure_more_bytes(self, 1)) {
+        result = next_byte(self, consume);
+    }
+    unlock(self);
+    return result;
+}
+
+static void release_bytes(ELTN_Buffer* self, size_t len) {
+    if (len > buffer_length(self)) {
+        len = buffer_length(self);
+    }
+    if (len == 0) {
+        return;
     }
+    if (self->borrowed != NULL) {
+        self->borrowed += len;
+        return;
+    }
+    self->head = self->buffer + (self->head - self->buffer + len) % self->bufsize;
+    signal_not_full(self);
+}
 
-    return next_byte(self, consume);
+ssize_t ELTN_Buffer_next_span(void* state, size_t release, size_t offset,
+                              const char8_t** spanptr) {
+    ELTN_Buffer* self = (ELTN_Buffer *) state;
+    ssize_t result = 0;
+
+    lock(self);
+    release_bytes(self, release);
+    free_retired(self);
+    (*spanptr) = NULL;
+    if (ensure_more_bytes(self, offset + 1)) {
+        if (self->borrowed != NULL) {
+            (*spanptr) = self->borrowed + offset;
+            result = self->borrowed_end - (*spanptr);
+            self->span_in_ring = false;
+        } else {
+            const char8_t* start =
+                self->buffer + (self->head - self->buffer + offset) % self->bufsize;
+
+            (*spanptr) = start;
+            if (self->mirrored) {
+                result = ring_length(self) - offset;
+            } else if (start < self->tail) {
+                result = self->tail - start;
+            } else {
+                result = self->buffer + self->bufsize - start;
+            }
+            self->span_in_ring = true;
+        }
+    } else if (!self->eof && self->errcode == ELTN_OK) {
+        /*
+         * Nothing to read yet, but the buffer is still open for writing.
+         */
+        result = -1;
+    }
+    self->spanned = (result > 0) ? result : 0;
+    unlock(self);
+    return result;
 }
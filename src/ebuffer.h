@@ -26,6 +26,7 @@
 #define __ELTN_BUFFER
 
 #include "eltn.h"
+#include "convert.h"
 
 ELTN_Buffer* ELTN_Buffer_new_with_pool(ELTN_Pool * pool);
 
@@ -33,8 +34,26 @@ size_t ELTN_Buffer_length(ELTN_Buffer * s);
 
 ssize_t ELTN_Buffer_read(ELTN_Buffer * s, ELTN_Reader reader, void* ud);
 
+ssize_t ELTN_Buffer_read_lent(ELTN_Buffer * s, ELTN_Lender lender, void* ud);
+
 int32_t ELTN_Buffer_next_char(void* s, bool consume);
 
+ELTN_Error ELTN_Buffer_error(ELTN_Buffer * s);
+
+ssize_t ELTN_Buffer_next_span(void* s, size_t release, size_t offset,
+                              const char8_t** spanptr);
+
+bool ELTN_Buffer_is_lent(ELTN_Buffer * s);
+
+/**
+ * A function that releases resources the buffer reads from, such as a
+ * memory mapping or an open file, when the buffer is freed.
+ */
+typedef void (*ELTN_Buffer_Cleanup) (void* state);
+
+void ELTN_Buffer_set_cleanup(ELTN_Buffer * s, ELTN_Buffer_Cleanup fcn,
+                             void* state);
+
 void ELTN_Buffer_free(ELTN_Buffer * self);
 
 #endif /* __ELTN_BUFFER */
@@ -50,7 +50,8 @@ static Name_Record EVENT_NAMES[] = {
     {ELTN_VALUE_NIL, "ELTN_VALUE_NIL"},
     {ELTN_TABLE_START, "ELTN_TABLE_START"},
     {ELTN_TABLE_END, "ELTN_TABLE_END"},
-    {ELTN_STREAM_END, "ELTN_STREAM_END"}
+    {ELTN_STREAM_END, "ELTN_STREAM_END"},
+    {ELTN_NEED_MORE_INPUT, "ELTN_NEED_MORE_INPUT"}
 };
 
 static Name_Record ERROR_NAMES[] = {
@@ -60,7 +61,33 @@ static Name_Record ERROR_NAMES[] = {
     {ELTN_ERR_STREAM_END, "ELTN_ERR_STREAM_END"},
     {ELTN_ERR_UNEXPECTED_TOKEN, "ELTN_ERR_UNEXPECTED_TOKEN"},
     {ELTN_ERR_INVALID_TOKEN, "ELTN_ERR_INVALID_TOKEN"},
-    {ELTN_ERR_DUPLICATE_KEY, "ELTN_ERR_DUPLICATE_KEY"}
+    {ELTN_ERR_DUPLICATE_KEY, "ELTN_ERR_DUPLICATE_KEY"},
+    {ELTN_ERR_LIMIT_EXCEEDED, "ELTN_ERR_LIMIT_EXCEEDED"},
+    {ELTN_ERR_READ, "ELTN_ERR_READ"}
+};
+
+static Name_Record TOKEN_NAMES[] = {
+    {ELTN_TOKEN_ERROR, "ELTN_TOKEN_ERROR"},
+    {ELTN_TOKEN_INVALID, "ELTN_TOKEN_INVALID"},
+    {ELTN_TOKEN_CURLY_OPEN, "ELTN_TOKEN_CURLY_OPEN"},
+    {ELTN_TOKEN_CURLY_CLOSE, "ELTN_TOKEN_CURLY_CLOSE"},
+    {ELTN_TOKEN_SQUARE_OPEN, "ELTN_TOKEN_SQUARE_OPEN"},
+    {ELTN_TOKEN_SQUARE_CLOSE, "ELTN_TOKEN_SQUARE_CLOSE"},
+    {ELTN_TOKEN_SEMICOLON, "ELTN_TOKEN_SEMICOLON"},
+    {ELTN_TOKEN_COMMA, "ELTN_TOKEN_COMMA"},
+    {ELTN_TOKEN_EQUALS, "ELTN_TOKEN_EQUALS"},
+    {ELTN_TOKEN_NAME, "ELTN_TOKEN_NAME"},
+    {ELTN_TOKEN_STRING, "ELTN_TOKEN_STRING"},
+    {ELTN_TOKEN_LONG_STRING, "ELTN_TOKEN_LONG_STRING"},
+    {ELTN_TOKEN_NUMBER, "ELTN_TOKEN_NUMBER"},
+    {ELTN_TOKEN_INTEGER, "ELTN_TOKEN_INTEGER"},
+    {ELTN_TOKEN_BOOLEAN_TRUE, "ELTN_TOKEN_BOOLEAN_TRUE"},
+    {ELTN_TOKEN_BOOLEAN_FALSE, "ELTN_TOKEN_BOOLEAN_FALSE"},
+    {ELTN_TOKEN_NIL, "ELTN_TOKEN_NIL"},
+    {ELTN_TOKEN_COMMENT, "ELTN_TOKEN_COMMENT"},
+    {ELTN_TOKEN_LONG_COMMENT, "ELTN_TOKEN_LONG_COMMENT"},
+    {ELTN_TOKEN_EOF, "ELTN_TOKEN_EOF"},
+    {ELTN_TOKEN_NEED_MORE, "ELTN_TOKEN_NEED_MORE"}
 };
 
 static const size_t ERROR_NAME_COUNT =
@@ -73,7 +100,7 @@ static void name_to_string(const char* name, char** strptr, size_t* sizeptr) {
 }
 
 ELTN_API const char* ELTN_Event_name(ELTN_Event e) {
-    if (e < ELTN_ERROR || e > ELTN_STREAM_END) {
+    if (e < ELTN_ERROR || e > ELTN_NEED_MORE_INPUT) {
         return "";
     } else {
         return EVENT_NAMES[e - ELTN_ERROR].name;
@@ -107,3 +134,11 @@ ELTN_API const char* ELTN_Error_name(ELTN_Error e) {
 ELTN_API void ELTN_Error_string(ELTN_Error e, char** strptr, size_t* sizeptr) {
     name_to_string(ELTN_Error_name(e), strptr, sizeptr);
 }
+
+ELTN_API const char* ELTN_Token_name(ELTN_Token t) {
+    if (t < ELTN_TOKEN_ERROR || t > ELTN_TOKEN_NEED_MORE) {
+        return "";
+    } else {
+        return TOKEN_NAMES[t - ELTN_TOKEN_ERROR].name;
+    }
+}
@@ -100,3 +100,192 @@ ELTN_API ssize_t ELTN_Emitter_write_file(ELTN_Emitter* self, FILE* fp) {
 }
 
 #endif
+
+#ifndef ELTN_NO_POSIX
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define  ELTN_CORE	1
+#include "eltn.h"
+#include "ebuffer.h"
+
+#define FD_BUFSIZE      (64 * 1024)
+#define HUGE_PAGE_SIZE  (2 * 1024 * 1024)
+
+typedef struct File_Map {
+    void* addr;
+    size_t len;
+} File_Map;
+
+typedef struct Fd_State {
+    int fd;
+    bool owned;
+    char block[FD_BUFSIZE];
+} Fd_State;
+
+static void File_Map_free(void* state) {
+    File_Map* map = (File_Map *) state;
+
+    munmap(map->addr, map->len);
+    free(map);
+}
+
+static void Fd_State_free(void* state) {
+    Fd_State* fds = (Fd_State *) state;
+
+    if (fds->owned && fds->fd >= 0) {
+        close(fds->fd);
+    }
+    free(fds);
+}
+
+/*
+ * Lends the same block for every read; the buffer releases each chunk
+ * before it borrows the next.
+ */
+static int Fd_Lender(void* state, const char** strptr, size_t* sizeptr,
+                     ELTN_Release* releaseptr) {
+    Fd_State* fds;
+    ssize_t nread;
+
+    if (state == NULL || strptr == NULL || sizeptr == NULL) {
+        return -1;
+    }
+
+    fds = (Fd_State *) state;
+
+    (*strptr) = NULL;
+    (*sizeptr) = 0;
+    (*releaseptr) = NULL;
+
+    do {
+        nread = read(fds->fd, fds->block, FD_BUFSIZE);
+    } while (nread < 0 && errno == EINTR);
+
+    if (nread <= 0) {
+        return (nread < 0) ? errno : 0;
+    }
+    (*strptr) = fds->block;
+    (*sizeptr) = (size_t)nread;
+    return 0;
+}
+
+static ssize_t map_file(ELTN_Parser* self, int fd, size_t size) {
+    ELTN_Buffer* buffer = ELTN_Parser_buffer(self);
+    File_Map* map;
+    void* addr;
+    ssize_t result;
+
+    addr = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) {
+        return -1;
+    }
+
+    /*
+     * Both are only hints; the mapping works the same if they fail.
+     */
+#ifdef MADV_SEQUENTIAL
+    madvise(addr, size, MADV_SEQUENTIAL);
+#endif
+#ifdef MADV_HUGEPAGE
+    if (size >= HUGE_PAGE_SIZE) {
+        madvise(addr, size, MADV_HUGEPAGE);
+    }
+#endif
+
+    map = (File_Map *) malloc(sizeof(File_Map));
+    if (map == NULL) {
+        munmap(addr, size);
+        return -1;
+    }
+    map->addr = addr;
+    map->len = size;
+
+    result = ELTN_Buffer_borrow(buffer, (const char *)addr, size);
+    if (result < 0) {
+        File_Map_free(map);
+        return -1;
+    }
+    ELTN_Buffer_set_cleanup(buffer, File_Map_free, map);
+    return result;
+}
+
+static ssize_t read_fd(ELTN_Parser* self, int fd, bool owned) {
+    ELTN_Buffer* buffer = ELTN_Parser_buffer(self);
+    struct stat st;
+    Fd_State* fds;
+    ssize_t result;
+
+    /*
+     * Map regular files whole.  Files that report a size of zero may be
+     * empty or may be generated on the fly (e.g. under /proc), so read
+     * those like pipes.
+     */
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0
+        && (uintmax_t)st.st_size <= SIZE_MAX) {
+        result = map_file(self, fd, (size_t)st.st_size);
+
+        if (result >= 0) {
+            if (owned) {
+                close(fd);
+            }
+            return result;
+        }
+    }
+
+    fds = (Fd_State *) malloc(sizeof(Fd_State));
+    if (fds == NULL) {
+        if (owned) {
+            close(fd);
+        }
+        return -1;
+    }
+    fds->fd = fd;
+    fds->owned = owned;
+
+    /*
+     * The buffer only owns the descriptor once it has taken the lender;
+     * after a failure it never calls the lender again.
+     */
+    result = ELTN_Parser_read_lent(self, Fd_Lender, fds);
+    if (result < 0) {
+        Fd_State_free(fds);
+        return -1;
+    }
+    ELTN_Buffer_set_cleanup(buffer, Fd_State_free, fds);
+    return result;
+}
+
+ELTN_API ssize_t ELTN_Parser_read_fd(ELTN_Parser* self, int fd) {
+    if (fd < 0) {
+        return -1;
+    }
+
+    return read_fd(self, fd, false);
+}
+
+ELTN_API ssize_t ELTN_Parser_read_path(ELTN_Parser* self, const char* path) {
+    int fd;
+
+    if (path == NULL) {
+        return -1;
+    }
+
+    do {
+        fd = open(path, O_RDONLY);
+    } while (fd < 0 && errno == EINTR);
+
+    if (fd < 0) {
+        return -1;
+    }
+
+    return read_fd(self, fd, true);
+}
+
+#endif
@@ -0,0 +1,91 @@
+/*****************************************************************************
+ *
+ * Copyright 2025 Frank Mitchell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ ****************************************************************************/
+
+
+#include <stdint.h>
+
+#define  ELTN_CORE    1
+#include "eltn.h"
+
+#define M   0xc6a4a7935bd1e995ULL
+#define R   47
+
+/*
+ * Eight bytes as a little-endian integer, so hashes are the same on every
+ * platform.  Compilers turn this into a single load where they can.
+ */
+static inline uint64_t load64(const uint8_t* p) {
+    return (uint64_t)p[0] | ((uint64_t)p[1] << 8)
+        | ((uint64_t)p[2] << 16) | ((uint64_t)p[3] << 24)
+        | ((uint64_t)p[4] << 32) | ((uint64_t)p[5] << 40)
+        | ((uint64_t)p[6] << 48) | ((uint64_t)p[7] << 56);
+}
+
+/*
+ * MurmurHash64A, by Austin Appleby, who placed it in the public domain.
+ */
+ELTN_API uint64_t ELTN_hash(const void* data, size_t len, uint64_t seed) {
+    const uint8_t* p = (const uint8_t *)data;
+    const uint8_t* end = p + (len & ~(size_t)7);
+    uint64_t h = seed ^ (len * M);
+
+    for (; p < end; p += 8) {
+        uint64_t k = load64(p);
+
+        k *= M;
+        k ^= k >> R;
+        k *= M;
+        h ^= k;
+        h *= M;
+    }
+
+    switch (len & 7) {
+    case 7:
+        h ^= (uint64_t)p[6] << 48;
+        /* fall through */
+    case 6:
+        h ^= (uint64_t)p[5] << 40;
+        /* fall through */
+    case 5:
+        h ^= (uint64_t)p[4] << 32;
+        /* fall through */
+    case 4:
+        h ^= (uint64_t)p[3] << 24;
+        /* fall through */
+    case 3:
+        h ^= (uint64_t)p[2] << 16;
+        /* fall through */
+    case 2:
+        h ^= (uint64_t)p[1] << 8;
+        /* fall through */
+    case 1:
+        h ^= (uint64_t)p[0];
+        h *= M;
+    }
+
+    h ^= h >> R;
+    h *= M;
+    h ^= h >> R;
+    return h;
+}
@@ -0,0 +1,227 @@
+/*****************************************************************************
+ *
+ * Copyright 2025 Frank Mitchell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ ****************************************************************************/
+
+
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+
+#define ELTN_CORE   1
+#include "eltn.h"
+#include "eintern.h"
+#include "ealloc.h"
+
+#define INIT_SLOTS      16      /* a power of 2 */
+#define INIT_STRINGS    8
+
+/*
+ * A string and its hash; its ID is its index in the strings array.
+ */
+typedef struct Interned {
+    char* str;
+    size_t len;
+    uint64_t hash;
+} Interned;
+
+struct Intern_Table {
+    intptr_t _reserved;
+    ELTN_Pool* pool;
+
+    /*
+     * Open addressing with linear probing: each slot holds 1 + the ID of
+     * a string, or 0 if empty.  The table is never more than half full.
+     */
+    int* slots;
+    size_t nslots;
+
+    Interned* strings;
+    size_t nstrings;
+    size_t maxstrings;
+
+    uint64_t seed;              /* for ELTN_hash() */
+};
+
+Intern_Table* Intern_Table_new_with_pool(ELTN_Pool* pool) {
+    Intern_Table* self = ELTN_alloc(pool, sizeof(Intern_Table));
+
+    if (self == NULL) {
+        return NULL;
+    }
+    self->pool = pool;
+    ELTN_Pool_acquire(&(self->pool));
+
+    self->nslots = INIT_SLOTS;
+    self->slots = ELTN_alloc(pool, sizeof(int) * self->nslots);
+    self->maxstrings = INIT_STRINGS;
+    self->strings = ELTN_alloc(pool, sizeof(Interned) * self->maxstrings);
+    if (self->slots == NULL || self->strings == NULL) {
+        Intern_Table_free(self);
+        return NULL;
+    }
+    return self;
+}
+
+void Intern_Table_free(Intern_Table* self) {
+    ELTN_Pool* h;
+
+    if (self == NULL) {
+        return;
+    }
+    h = self->pool;
+    for (size_t i = 0; i < self->nstrings; i++) {
+        ELTN_free(h, self->strings[i].str);
+    }
+    ELTN_free(h, self->strings);
+    ELTN_free(h, self->slots);
+    ELTN_free(h, self);
+    ELTN_Pool_release(&h);
+}
+
+size_t Intern_Table_size(Intern_Table* self) {
+    return self->nstrings;
+}
+
+/*
+ * The slot that holds `str`, or the empty slot where it would go.
+ */
+static size_t find_slot(Intern_Table* self, const char* str, size_t len,
+                        uint64_t hash) {
+    const size_t mask = self->nslots - 1;
+    size_t index = hash & mask;
+
+    for (;;) {
+        const int entry = self->slots[index];
+        const Interned* p;
+
+        if (entry == 0) {
+            return index;
+        }
+        p = &(self->strings[entry - 1]);
+        if (p->hash == hash && p->len == len
+            && (len == 0 || memcmp(p->str, str, len) == 0)) {
+            return index;
+        }
+        index = (index + 1) & mask;
+    }
+}
+
+static bool grow_slots(Intern_Table* self) {
+    const size_t newlen = self->nslots * 2;
+    int* oldslots = self->slots;
+    int* newslots = ELTN_alloc(self->pool, sizeof(int) * newlen);
+
+    if (newslots == NULL) {
+        return false;
+    }
+    self->slots = newslots;
+    self->nslots = newlen;
+    for (size_t i = 0; i < self->nstrings; i++) {
+        const Interned* p = &(self->strings[i]);
+
+        self->slots[find_slot(self, p->str, p->len, p->hash)] = (int)i + 1;
+    }
+    ELTN_free(self->pool, oldslots);
+    return true;
+}
+
+uint64_t Intern_Table_seed(Intern_Table* self) {
+    return self->seed;
+}
+
+void Intern_Table_set_seed(Intern_Table* self, uint64_t seed) {
+    if (seed == self->seed) {
+        return;
+    }
+    self->seed = seed;
+    memset(self->slots, 0, sizeof(int) * self->nslots);
+    for (size_t i = 0; i < self->nstrings; i++) {
+        Interned* p = &(self->strings[i]);
+
+        p->hash = ELTN_hash(p->str, p->len, seed);
+        self->slots[find_slot(self, p->str, p->len, p->hash)] = (int)i + 1;
+    }
+}
+
+uint64_t Intern_Table_hash(Intern_Table* self, const char* str, size_t len) {
+    return ELTN_hash(str, len, self->seed);
+}
+
+int Intern_Table_find(Intern_Table* self, const char* str, size_t len,
+                      uint64_t hash) {
+    return self->slots[find_slot(self, str, len, hash)] - 1;
+}
+
+int Intern_Table_add(Intern_Table* self, const char* str, size_t len,
+                     uint64_t hash) {
+    size_t index = find_slot(self, str, len, hash);
+    Interned* p;
+
+    if (self->slots[index] != 0) {
+        return self->slots[index] - 1;
+    }
+    if (self->nstrings >= INT_MAX - 1) {
+        return -1;
+    }
+    if (self->nstrings >= self->maxstrings) {
+        const size_t max = self->maxstrings * 2;
+        Interned* tmp = ELTN_realloc(self->pool, self->strings,
+                                     sizeof(Interned) * max);
+
+        if (tmp == NULL) {
+            return -1;
+        }
+        self->strings = tmp;
+        self->maxstrings = max;
+    }
+    if (2 * (self->nstrings + 1) > self->nslots) {
+        if (!grow_slots(self)) {
+            return -1;
+        }
+        index = find_slot(self, str, len, hash);
+    }
+
+    p = &(self->strings[self->nstrings]);
+    p->str = ELTN_alloc(self->pool, len + 1);
+    if (p->str == NULL) {
+        return -1;
+    }
+    if (len > 0) {
+        memcpy(p->str, str, len);
+    }
+    p->len = len;
+    p->hash = hash;
+    self->nstrings++;
+    self->slots[index] = (int)self->nstrings;
+    return (int)self->nstrings - 1;
+}
+
+const char* Intern_Table_string(Intern_Table* self, int id, size_t* lenptr) {
+    if (id < 0 || (size_t)id >= self->nstrings) {
+        return NULL;
+    }
+    if (lenptr != NULL) {
+        (*lenptr) = self->strings[id].len;
+    }
+    return self->strings[id].str;
+}
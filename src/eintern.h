@@ -0,0 +1,79 @@
+/*****************************************************************************
+ *
+ * Copyright 2025 Frank Mitchell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ ****************************************************************************/
+
+
+#ifndef __ELTN_INTERN
+#define __ELTN_INTERN
+
+#include <stdint.h>
+#include "eltn.h"
+
+/*
+ * Maps strings to small integer IDs, 0 for the first string added, 1 for
+ * the second, and so on.  A string's ID never changes, and neither does
+ * the table's copy of it.
+ */
+typedef struct Intern_Table Intern_Table;
+
+Intern_Table* Intern_Table_new_with_pool(ELTN_Pool * pool);
+
+size_t Intern_Table_size(Intern_Table * t);
+
+/*
+ * The seed for hashing strings, 0 by default.  Changing it rehashes
+ * every string in the table.
+ */
+uint64_t Intern_Table_seed(Intern_Table * t);
+
+void Intern_Table_set_seed(Intern_Table * t, uint64_t seed);
+
+/*
+ * The hash of `str` with the table's seed, as the `hash` argument below
+ * must be.  Callers that already have ELTN_hash(str, len, seed) should
+ * pass it along rather than hash the string again.
+ */
+uint64_t Intern_Table_hash(Intern_Table * t, const char* str, size_t len);
+
+/*
+ * The ID of `str`, or -1 if it hasn't been added.
+ */
+int Intern_Table_find(Intern_Table * t, const char* str, size_t len,
+                      uint64_t hash);
+
+/*
+ * The ID of `str`, adding it if it isn't there already, or -1 if out of
+ * memory.
+ */
+int Intern_Table_add(Intern_Table * t, const char* str, size_t len,
+                     uint64_t hash);
+
+/*
+ * The table's copy of the string with ID `id`, null-terminated, or NULL
+ * if there is none.
+ */
+const char* Intern_Table_string(Intern_Table * t, int id, size_t* lenptr);
+
+void Intern_Table_free(Intern_Table * t);
+
+#endif /* __ELTN_INTERN */
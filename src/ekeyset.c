@@ -130,26 +130,12 @@ static bool is_equal(Key* a, Key* b) {
 }
 
 static uint_fast64_t hash_string(const char* str, size_t len) {
-    /*
-     * Vibe-coded from
-     * <https://cp-algorithms.com/string/string-hashing.html>
-     */
     if (str == NULL || len == 0) {
         return 0;
     }
-    const int p = 31;
-    const int m = 1e9 + 9;
-    int_fast64_t hash_value = 0;
-    int_fast64_t p_pow = 1;
-
-    for (int i = 0; i < len; i++) {
-        char c = str[i];
-
-        hash_value = (hash_value + (c - 'a' + 1) * p_pow) % m;
-        p_pow = (p_pow * p) % m;
-    }
-    return 0x7FFFFFFF & hash_value;
+    return ELTN_hash(str, len, 0);
 }
+
 static uint_fast64_t hash_double(double val) {
     return hash_string((const char *)&val, sizeof(double) / sizeof(char));
 }
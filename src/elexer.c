@@ -22,43 +22,171 @@
  *
  ****************************************************************************/
 
-#include <math.h>
 #include <stdlib.h>
 #include <string.h>
 
 #define ELTN_CORE   1
 #include "eltn.h"
 #include "elexer.h"
+#include "enumber.h"
 #include "ebuffer.h"
 #include "ealloc.h"
+#include "escan.h"
 #include "estring.h"
 
 #define INIT_BUF_SIZE 1024
 
-#define KEYWORDS_SIZE 22
+/*
+ * A token buffer bigger than this shrinks back to INIT_BUF_SIZE before
+ * the next token, so one huge string doesn't pin its memory for good.
+ */
+#define MAX_IDLE_BUF_SIZE (64 * 1024)
 
-const char* KEYWORDS[] = {
-    "and", "break", "do", "else", "elseif", "end",
-    "false", "for", "function", "goto", "if", "in",
-    "local", "nil", "not", "or", "repeat", "return",
-    "then", "true", "until", "while"
+/*
+ * Reserved words, indexed by a perfect hash of their length and first,
+ * second and last characters, so recognizing one takes a single probe.
+ * The compiler works out each word's slot from KEYWORD_HASH;
+ * test_lexer_invalid_keywords would catch any two that collide.
+ */
+#define KEYWORD_SLOTS       64
+#define MIN_KEYWORD_LENGTH  2
+#define MAX_KEYWORD_LENGTH  8
+
+#define KEYWORD_HASH(len, first, second, last) \
+    (((len) + (first) + ((second) << 3) + (last)) & (KEYWORD_SLOTS - 1))
+
+#define KEYWORD(word, first, second, last, token) \
+    [KEYWORD_HASH(sizeof(word) - 1, first, second, last)] = \
+        { word, sizeof(word) - 1, token }
+
+typedef struct Keyword {
+    const char* word;
+    size_t len;
+    ELTN_Token token;           /* ELTN_TOKEN_INVALID if merely reserved */
+} Keyword;
+
+static const Keyword KEYWORDS[KEYWORD_SLOTS] = {
+    KEYWORD("and", 'a', 'n', 'd', ELTN_TOKEN_INVALID),
+    KEYWORD("break", 'b', 'r', 'k', ELTN_TOKEN_INVALID),
+    KEYWORD("do", 'd', 'o', 'o', ELTN_TOKEN_INVALID),
+    KEYWORD("else", 'e', 'l', 'e', ELTN_TOKEN_INVALID),
+    KEYWORD("elseif", 'e', 'l', 'f', ELTN_TOKEN_INVALID),
+    KEYWORD("end", 'e', 'n', 'd', ELTN_TOKEN_INVALID),
+    KEYWORD("false", 'f', 'a', 'e', ELTN_TOKEN_BOOLEAN_FALSE),
+    KEYWORD("for", 'f', 'o', 'r', ELTN_TOKEN_INVALID),
+    KEYWORD("function", 'f', 'u', 'n', ELTN_TOKEN_INVALID),
+    KEYWORD("goto", 'g', 'o', 'o', ELTN_TOKEN_INVALID),
+    KEYWORD("if", 'i', 'f', 'f', ELTN_TOKEN_INVALID),
+    KEYWORD("in", 'i', 'n', 'n', ELTN_TOKEN_INVALID),
+    KEYWORD("local", 'l', 'o', 'l', ELTN_TOKEN_INVALID),
+    KEYWORD("nil", 'n', 'i', 'l', ELTN_TOKEN_NIL),
+    KEYWORD("not", 'n', 'o', 't', ELTN_TOKEN_INVALID),
+    KEYWORD("or", 'o', 'r', 'r', ELTN_TOKEN_INVALID),
+    KEYWORD("repeat", 'r', 'e', 't', ELTN_TOKEN_INVALID),
+    KEYWORD("return", 'r', 'e', 'n', ELTN_TOKEN_INVALID),
+    KEYWORD("then", 't', 'h', 'n', ELTN_TOKEN_INVALID),
+    KEYWORD("true", 't', 'r', 'e', ELTN_TOKEN_BOOLEAN_TRUE),
+    KEYWORD("until", 'u', 'n', 'l', ELTN_TOKEN_INVALID),
+    KEYWORD("while", 'w', 'h', 'e', ELTN_TOKEN_INVALID),
 };
 
+#undef KEYWORD
+
+/*
+ * What ELTN_Lexer_rewind() needs to restore, besides the input position.
+ */
+typedef struct Lexer_State {
+    char8_t current_char;
+    size_t line_counted;
+    size_t line_start;
+    int line;
+    bool pushback;
+    bool eos;
+} Lexer_State;
+
 struct ELTN_Lexer {
     intptr_t _reserved;
     ELTN_Pool* pool;
-    ELTN_Char_Source get_next_char;
+    ELTN_Span_Source get_next_span;
     void* source;
 
+    /*
+     * The span of input being read, and how far the lexer has read it.
+     */
+    const char8_t* span;
+    const char8_t* cursor;
+    const char8_t* limit;
+
     char8_t current_char;
-    int count;
-    int line;
-    int column;
     char8_t* token_buffer;
     char8_t* token_buffer_tail;
     size_t token_buffer_size;
+
+    /*
+     * Until it has to be copied into the token buffer, because it crosses
+     * into another span or leaves out some bytes, the current token is
+     * the bytes from token_start to token_end of the current span.
+     */
+    const char8_t* token_start;
+    const char8_t* token_end;
+    bool token_buffered;
+
+    /*
+     * Where the current token starts in the input and, once it has been
+     * asked for or the lexer is about to leave the token's span, its
+     * line and column.
+     */
+    size_t token_offset;
+    bool token_located;
+    int token_line;
+    int token_column;
+
+    /*
+     * Lines are only counted when a position is needed, or before the
+     * lexer leaves a span: the input up to `line_counted` has `line - 1`
+     * newlines, the last of which ends just before `line_start`.
+     */
+    size_t line_counted;
+    size_t line_start;
+    int line;
+
+    /*
+     * The value of the last ELTN_TOKEN_INTEGER or ELTN_TOKEN_NUMBER.
+     */
+    int64_t integer;
+    double number;
     bool pushback;
     bool eos;
+
+    /*
+     * Limits (0 if unlimited) and the first error encountered.
+     */
+    size_t max_token;
+    size_t max_input;
+    ELTN_Error errcode;
+
+    /*
+     * Whether to skip the text of short comments instead of keeping it.
+     */
+    bool skip_comments;
+
+    /*
+     * Bytes handed out before the current span and not yet released,
+     * and the total released so far.
+     */
+    size_t held;
+    size_t released;
+
+    /*
+     * In incremental mode, running out of input for now makes the current
+     * token ELTN_TOKEN_NEED_MORE; bytes from the mark on are kept so the
+     * lexer can rewind and try again once more arrive.
+     */
+    bool incremental;
+    bool dry;
+    bool marked;
+    size_t mark;
+    Lexer_State saved;
 };
 
 ELTN_Lexer* ELTN_Lexer_new_with_pool(ELTN_Pool* pool) {
@@ -76,6 +204,8 @@ ELTN_Lexer* ELTN_Lexer_new_with_pool(ELTN_Pool* pool) {
         return false;
     }
     self->token_buffer_tail = self->token_buffer;
+    self->token_located = true;
+    self->line = 1;
     return self;
 }
 
@@ -87,44 +217,197 @@ void ELTN_Lexer_free(ELTN_Lexer* self) {
     ELTN_Pool_release(&h);
 }
 
-void ELTN_Lexer_set_char_source(ELTN_Lexer* self, ELTN_Char_Source fcn,
+void ELTN_Lexer_set_span_source(ELTN_Lexer* self, ELTN_Span_Source fcn,
                                 void* state) {
-    self->get_next_char = fcn;
+    self->get_next_span = fcn;
     self->source = state;
+    self->span = NULL;
+    self->cursor = NULL;
+    self->limit = NULL;
+}
+
+void ELTN_Lexer_set_max_token_length(ELTN_Lexer* self, size_t len) {
+    self->max_token = len;
+}
+
+void ELTN_Lexer_set_max_input(ELTN_Lexer* self, size_t len) {
+    self->max_input = len;
+}
+
+void ELTN_Lexer_set_skip_comments(ELTN_Lexer* self, bool b) {
+    self->skip_comments = b;
+}
+
+ELTN_Error ELTN_Lexer_error(ELTN_Lexer* self) {
+    return self->errcode;
+}
+
+/*
+ * Record an error and stop reading: the current token is unusable,
+ * and so is the rest of the input.
+ */
+static void lexer_fail(ELTN_Lexer* self, ELTN_Error errcode) {
+    if (self->errcode == ELTN_OK) {
+        self->errcode = errcode;
+    }
+    self->eos = true;
+}
+
+static const char8_t* token_text(ELTN_Lexer* self) {
+    if (self->token_buffered || self->token_start == NULL) {
+        return self->token_buffer;
+    }
+    return self->token_start;
+}
+
+static size_t token_length(ELTN_Lexer* self) {
+    if (self->token_buffered) {
+        return self->token_buffer_tail - self->token_buffer;
+    }
+    return self->token_end - self->token_start;
+}
+
+void ELTN_Lexer_token_view(ELTN_Lexer* self, const char** strptr,
+                           size_t* lenptr) {
+    if (strptr && lenptr) {
+        (*strptr) = (const char *)token_text(self);
+        (*lenptr) = token_length(self);
+    }
+}
+
+int64_t ELTN_Lexer_integer(ELTN_Lexer* self) {
+    return self->integer;
+}
+
+double ELTN_Lexer_number(ELTN_Lexer* self) {
+    return self->number;
 }
 
 void ELTN_Lexer_token_string(ELTN_Lexer* self, char** strptr, size_t* lenptr) {
     if (strptr && lenptr) {
-        size_t toklen = self->token_buffer_tail - self->token_buffer;
+        ELTN_new_string(strptr, lenptr, (const char *)token_text(self),
+                        token_length(self));
+    }
+}
+
+/*
+ * Release the span just read and fetch the next one.
+ */
+static bool token_spill(ELTN_Lexer* self);
+
+static void locate_token(ELTN_Lexer* self);
+
+static void count_lines(ELTN_Lexer* self, const char8_t* end);
+
+static bool next_span(ELTN_Lexer* self) {
+    const char8_t* span = NULL;
+    const size_t total = self->held + (self->limit - self->span);
+    const size_t release = self->marked ? self->mark : total;
+    ssize_t len;
+
+    /*
+     * The current span may be gone once released, and the lexer won't
+     * come back to it anyway.
+     */
+    token_spill(self);
+    locate_token(self);
+    count_lines(self, self->limit);
+    len = self->get_next_span(self->source, release, total - release, &span);
 
-        ELTN_new_string(strptr, lenptr, (const char *)self->token_buffer,
-                        toklen);
+    self->released += release;
+    self->held = total - release;
+    self->mark = 0;
+    self->span = NULL;
+    self->cursor = NULL;
+    self->limit = NULL;
+
+    if (len < 0 && self->incremental) {
+        self->dry = true;
+        return false;
     }
+    if (len <= 0 || span == NULL) {
+        return false;
+    }
+    if (self->max_input > 0
+        && self->released + self->held + len > self->max_input) {
+        lexer_fail(self, ELTN_ERR_LIMIT_EXCEEDED);
+        return false;
+    }
+    self->span = span;
+    self->cursor = span;
+    self->limit = span + len;
+    return true;
 }
 
-static int32_t get_next_char(ELTN_Lexer* self) {
-    const char8_t last = self->current_char;
+void ELTN_Lexer_set_incremental(ELTN_Lexer* self, bool b) {
+    self->incremental = b;
+}
+
+void ELTN_Lexer_mark(ELTN_Lexer* self) {
+    self->marked = true;
+    self->mark = self->held + (self->cursor - self->span);
+    self->dry = false;
+    self->saved.current_char = self->current_char;
+
+    /*
+     * Rewinding loses the input before the mark, so count lines up to
+     * it now, including a character pushed back: it is handed out again
+     * from `current_char`, but reading resumes after it.  The current
+     * token, before it, has to be located first.
+     */
+    if (self->span != NULL) {
+        locate_token(self);
+        count_lines(self, self->cursor);
+    }
+    self->saved.line_counted = self->line_counted;
+    self->saved.line_start = self->line_start;
+    self->saved.line = self->line;
+    self->saved.pushback = self->pushback;
+    self->saved.eos = self->eos;
+}
+
+void ELTN_Lexer_unmark(ELTN_Lexer* self) {
+    self->marked = false;
+}
+
+void ELTN_Lexer_rewind(ELTN_Lexer* self) {
+    if (!self->marked) {
+        return;
+    }
+    self->current_char = self->saved.current_char;
+    self->line_counted = self->saved.line_counted;
+    self->line_start = self->saved.line_start;
+    self->line = self->saved.line;
+    self->token_located = true;
+    self->pushback = self->saved.pushback;
+    self->eos = self->saved.eos;
+    self->dry = false;
+
+    /*
+     * Forget everything handed out past the mark; the next span
+     * starts there.
+     */
+    self->held = self->mark;
+    self->span = NULL;
+    self->cursor = NULL;
+    self->limit = NULL;
+}
 
+static int32_t get_next_char(ELTN_Lexer* self) {
     if (self->pushback) {
         self->pushback = false;
-        return last;
+        return self->current_char;
     }
 
     if (self->eos) {
         return -1;
     }
 
-    int32_t result = self->get_next_char(self->source, true);
+    int32_t result = -1;
 
-    self->count++;
-    if (self->count == 1) {
-        self->line = 1;
-        self->column = 1;
-    } else if (last == '\n') {
-        self->line++;
-        self->column = 1;
-    } else {
-        self->column++;
+    if (self->cursor < self->limit || next_span(self)) {
+        result = *(self->cursor);
+        self->cursor++;
     }
 
     if (result < 0) {
@@ -138,266 +421,595 @@ static int32_t get_next_char(ELTN_Lexer* self) {
 }
 
 static bool token_buffer_clear(ELTN_Lexer* self) {
+    if (self->token_buffer_size > MAX_IDLE_BUF_SIZE) {
+        char8_t* tmp =
+            ELTN_realloc(self->pool, self->token_buffer, INIT_BUF_SIZE);
+
+        if (tmp != NULL) {
+            self->token_buffer = tmp;
+            self->token_buffer_size = INIT_BUF_SIZE;
+        }
+    }
     self->token_buffer_tail = self->token_buffer;
-    memset(self->token_buffer, 0, self->token_buffer_size);
+    (*self->token_buffer_tail) = '\0';
+    self->token_start = NULL;
+    self->token_end = NULL;
+    self->token_buffered = false;
     return true;
 }
 
-static bool token_buffer_append(ELTN_Lexer* self, int32_t cp) {
+/*
+ * Make room for `len` more bytes plus a terminating NUL, doubling the
+ * buffer as needed so a token of any length costs linear time.
+ */
+static bool token_buffer_reserve(ELTN_Lexer* self, size_t len) {
     const size_t toklen = self->token_buffer_tail - self->token_buffer;
-    const size_t tokmax = self->token_buffer_size;
+    size_t tokmax = self->token_buffer_size;
 
-    if (cp < 0) {
+    if (self->max_token > 0 && toklen + len > self->max_token) {
+        lexer_fail(self, ELTN_ERR_LIMIT_EXCEEDED);
         return false;
     }
-
-    if (toklen + 1 >= tokmax) {
-        char8_t* tmp = ELTN_realloc(self->pool, self->token_buffer,
-                                    tokmax + INIT_BUF_SIZE);
-
-        if (tmp == NULL) {
+    if (toklen + len < tokmax) {
+        return true;
+    }
+    while (toklen + len >= tokmax) {
+        if (tokmax > SIZE_MAX / 2) {
+            lexer_fail(self, ELTN_ERR_OUT_OF_MEMORY);
             return false;
         }
-        self->token_buffer = tmp;
-        self->token_buffer_tail = tmp + toklen;
+        tokmax *= 2;
+    }
+
+    char8_t* tmp = ELTN_realloc(self->pool, self->token_buffer, tokmax);
+
+    if (tmp == NULL) {
+        lexer_fail(self, ELTN_ERR_OUT_OF_MEMORY);
+        return false;
     }
-    *(self->token_buffer_tail) = (char8_t) cp;
-    self->token_buffer_tail++;
+    self->token_buffer = tmp;
+    self->token_buffer_tail = tmp + toklen;
+    self->token_buffer_size = tokmax;
+    return true;
+}
+
+/*
+ * Copy `len` bytes to the end of the token buffer.
+ */
+static bool token_buffer_copy(ELTN_Lexer* self, const char8_t* bytes,
+                              size_t len) {
+    if (!token_buffer_reserve(self, len)) {
+        return false;
+    }
+    memcpy(self->token_buffer_tail, bytes, len);
+    self->token_buffer_tail += len;
     (*self->token_buffer_tail) = '\0';
     return true;
 }
 
-static size_t token_buffer_length(ELTN_Lexer* self) {
-    return self->token_buffer_tail - self->token_buffer;
+/*
+ * Copy the current token into the token buffer, if it isn't there already.
+ */
+static bool token_spill(ELTN_Lexer* self) {
+    const char8_t* start = self->token_start;
+    const size_t len = self->token_end - start;
+
+    if (self->token_buffered) {
+        return true;
+    }
+    self->token_buffered = true;
+    self->token_start = NULL;
+    self->token_end = NULL;
+    return len == 0 || token_buffer_copy(self, start, len);
 }
 
-static bool token_buffer_equals(ELTN_Lexer* self, const char* str) {
-    const size_t toklen = self->token_buffer_tail - self->token_buffer;
+/*
+ * Add `len` bytes of the current span to the token: by extending the
+ * token's slice of the span if they follow it, otherwise by copying.
+ */
+static bool token_buffer_add(ELTN_Lexer* self, const char8_t* bytes,
+                             size_t len) {
+    if (!self->token_buffered) {
+        if (self->token_end == NULL) {
+            self->token_start = bytes;
+            self->token_end = bytes;
+        }
+        if (self->token_end == bytes) {
+            if (self->max_token > 0
+                && token_length(self) + len > self->max_token) {
+                lexer_fail(self, ELTN_ERR_LIMIT_EXCEEDED);
+                return false;
+            }
+            self->token_end += len;
+            return true;
+        }
+        if (!token_spill(self)) {
+            return false;
+        }
+    }
+    return token_buffer_copy(self, bytes, len);
+}
 
-    return strncmp((const char *)(self->token_buffer), str, toklen) == 0;
+/*
+ * Add the character just read.
+ */
+static bool token_buffer_append(ELTN_Lexer* self, int32_t cp) {
+    char8_t c = (char8_t) cp;
+
+    if (cp < 0) {
+        return false;
+    }
+    if (self->cursor != NULL && self->cursor > self->span
+        && self->cursor[-1] == c) {
+        return token_buffer_add(self, self->cursor - 1, 1);
+    }
+    return token_spill(self) && token_buffer_copy(self, &c, 1);
 }
 
-static bool token_buffer_starts_with(ELTN_Lexer* self, const char* str) {
-    const size_t cmplen = strlen(str);
+/*
+ * Move the cursor ahead to `end` within the current span, as if each byte
+ * were read by get_next_char().  Returns where the cursor was.
+ */
+static const char8_t* advance_to(ELTN_Lexer* self, const char8_t* end) {
+    const char8_t* start = self->cursor;
+    const size_t len = end - start;
+
+    if (len == 0) {
+        return start;
+    }
+    self->current_char = end[-1];
+    self->cursor = end;
+    return start;
+}
 
-    return strncmp((const char *)(self->token_buffer), str, cmplen) == 0;
+/*
+ * Whether the cursor may skip ahead, i.e. no character has been pushed
+ * back and the input hasn't ended.
+ */
+static bool can_advance(ELTN_Lexer* self) {
+    return !self->pushback && !self->eos;
 }
 
-static bool token_buffer_ends_with(ELTN_Lexer* self, const char* str) {
-    const size_t cmplen = strlen(str);
-    const char* token_end = (const char *)(self->token_buffer_tail - cmplen);
+/*
+ * Step over the run of bytes from the cursor to the end of the current
+ * span whose class does (or, if not `match`, doesn't) overlap `mask`.
+ * Returns the start of the run.
+ */
+static const char8_t* skip_run(ELTN_Lexer* self, uint16_t mask, bool match) {
+    const char8_t* ptr = self->cursor;
 
-    return strncmp(token_end, str, cmplen) == 0;
+    if (!can_advance(self)) {
+        return ptr;
+    }
+    while (ptr < self->limit && ELTN_CHAR_IS(*ptr, mask) == match) {
+        ptr++;
+    }
+    return advance_to(self, ptr);
 }
 
-static int strptrcmp(const void* a, const void* b) {
-    const char** astrptr = (const char **)a;
-    const char** bstrptr = (const char **)b;
+/*
+ * Append the bytes from `start` to the cursor to the token buffer.
+ */
+static void token_buffer_append_from(ELTN_Lexer* self, const char8_t* start) {
+    const size_t len = self->cursor - start;
 
-    return strcmp(*astrptr, *bstrptr);
+    if (len > 0) {
+        token_buffer_add(self, start, len);
+    }
 }
 
-static bool token_buffer_is_keyword(ELTN_Lexer* self) {
-    const char* token = (const char *)self->token_buffer;
+/*
+ * Append the run skip_run() steps over to the token buffer.
+ */
+static void token_buffer_append_run(ELTN_Lexer* self, uint16_t mask,
+                                    bool match) {
+    token_buffer_append_from(self, skip_run(self, mask, match));
+}
 
-    void* result =
-        bsearch(&token, KEYWORDS, KEYWORDS_SIZE, sizeof(char8_t *), strptrcmp);
+/*
+ * Append the bytes from `start` to the cursor to the token buffer,
+ * leaving out carriage returns.
+ */
+static void token_buffer_append_text(ELTN_Lexer* self, const char8_t* start) {
+    const char8_t* end = self->cursor;
+    const char8_t* cr;
 
-    return result != NULL;
+    while ((cr = memchr(start, '\r', end - start)) != NULL) {
+        if (cr > start && !token_buffer_add(self, start, cr - start)) {
+            return;
+        }
+        start = cr + 1;
+    }
+    if (end > start) {
+        token_buffer_add(self, start, end - start);
+    }
+}
+
+/*
+ * What the name in the token buffer really is: a boolean, nil, a reserved
+ * word (ELTN_TOKEN_INVALID), or just a name.
+ */
+static ELTN_Token token_buffer_name(ELTN_Lexer* self) {
+    const char8_t* text = token_text(self);
+    const size_t len = token_length(self);
+    const Keyword* keyword;
+
+    if (len < MIN_KEYWORD_LENGTH || len > MAX_KEYWORD_LENGTH) {
+        return ELTN_TOKEN_NAME;
+    }
+    keyword = &KEYWORDS[KEYWORD_HASH(len, text[0], text[1], text[len - 1])];
+    if (keyword->len == len && memcmp(keyword->word, text, len) == 0) {
+        return keyword->token;
+    }
+    return ELTN_TOKEN_NAME;
 }
 
 static ELTN_Token consume_until_matching_quote(ELTN_Lexer* self, char8_t quote) {
-    int32_t prev = quote;
-    int32_t curr = get_next_char(self);
-    bool quote_found = false;
+    int32_t curr;
 
-    while (!self->eos) {
+    for (;;) {
         /*
-         * No linebreaks in a string unless escaped with "\\" or "\\z".
+         * Copy plain text up to the next quote, backslash, or line break
+         * wholesale, then deal with that.
          */
+        if (can_advance(self)) {
+            token_buffer_append_from(self, advance_to(self,
+                ELTN_scan_string_stop(self->cursor, self->limit)));
+        }
+        curr = get_next_char(self);
         if (curr == '\r') {
-            curr = get_next_char(self);
             continue;
         }
-        if (curr == '\n') {
-            if (prev != '\\' && !token_buffer_ends_with(self, "\\z")) {
-                break;
-            }
+        /*
+         * No linebreaks in a string unless escaped with "\\" or "\\z".
+         */
+        if (curr < 0 || curr == '\n') {
+            break;
         }
         token_buffer_append(self, curr);
+        if (curr == quote) {
+            return ELTN_TOKEN_STRING;
+        }
+        if (curr != '\\') {
+            continue;
+        }
+
         /*
-         * Now check if we have a matching quote
+         * Whatever follows a backslash is part of the string; "\\z" skips
+         * all whitespace after it, including line breaks.
          */
-        if (curr == quote && prev != '\\') {
-            quote_found = true;
+        do {
+            curr = get_next_char(self);
+        } while (curr == '\r');
+        if (curr < 0) {
             break;
         }
-        prev = curr;
+        token_buffer_append(self, curr);
+        if (curr == 'z') {
+            curr = get_next_char(self);
+            while (ELTN_CHAR_IS(curr, ELTN_CLASS_SPACE)) {
+                if (curr != '\r') {
+                    token_buffer_append(self, curr);
+                }
+                curr = get_next_char(self);
+            }
+            if (curr < 0) {
+                break;
+            }
+            self->pushback = true;
+        }
+    }
+    return ELTN_TOKEN_INVALID;
+}
+
+/*
+ * Read the rest of the opening bracket of a long string or comment
+ * (/=*[/) after the first "[".  Returns its level, i.e. the number of
+ * '=', or -1 and the first byte that doesn't fit in `*currptr`.
+ */
+static ssize_t read_long_bracket(ELTN_Lexer* self, int32_t* currptr) {
+    ssize_t level = 0;
+    int32_t curr = get_next_char(self);
+
+    while (curr == '=') {
+        token_buffer_append(self, curr);
+        level++;
         curr = get_next_char(self);
     }
-    return quote_found ? ELTN_TOKEN_STRING : ELTN_TOKEN_INVALID;
+    if (curr == '[') {
+        token_buffer_append(self, curr);
+        return level;
+    }
+    (*currptr) = curr;
+    return -1;
 }
 
-static bool in_long_bracket(ELTN_Lexer* self, const char* prefix,
-                            ssize_t* depthptr) {
-    size_t prefix_length = strlen(prefix);
-    ssize_t depth = 0;
+/*
+ * Whether the token buffer ends with a closing bracket of `level`, not
+ * counting the first `open` bytes.  This only looks back over the '='
+ * just before the final ']', so checking each ']' takes linear time
+ * overall.
+ */
+static bool token_buffer_ends_with_long_bracket(ELTN_Lexer* self,
+                                                size_t open, size_t level) {
+    const char8_t* text = token_text(self);
+    const char8_t* ptr = text + token_length(self) - 1;
+    const char8_t* floor = text + open;
+    size_t equals = 0;
 
-    if (depthptr) {
-        depth = (*depthptr);
+    if (ptr - floor < (ssize_t)level + 1 || *ptr != ']') {
+        return false;
     }
-    if (depth >= 0
-        && token_buffer_length(self) > prefix_length
-        && token_buffer_starts_with(self, prefix)
-        && token_buffer_ends_with(self, "[")) {
-        if (token_buffer_ends_with(self, "[[")) {
-            if (depthptr) {
-                *depthptr = depth;
-            }
-            return true;
+    for (ptr--; equals <= level && *ptr == '='; ptr--) {
+        equals++;
+    }
+    return equals == level && *ptr == ']' && ptr >= floor;
+}
+
+/*
+ * Read the body of a long string or comment up to and including the
+ * closing bracket of `level`, jumping from one ']' to the next.
+ */
+static ELTN_Token consume_long_bracket(ELTN_Lexer* self, size_t level,
+                                       ELTN_Token token) {
+    const size_t open = token_length(self);
+    int32_t curr;
+
+    for (;;) {
+        if (can_advance(self)) {
+            const char8_t* end = memchr(self->cursor, ']',
+                                        self->limit - self->cursor);
+
+            token_buffer_append_text(self, advance_to(self,
+                (end != NULL) ? end : self->limit));
         }
-        for (const char8_t * ptr = self->token_buffer + prefix_length;
-             ptr <= self->token_buffer_tail; ptr++) {
-            if ((*ptr) == '=') {
-                depth++;
-            } else if ((*ptr) == '[') {
-                if (depthptr) {
-                    *depthptr = depth;
-                }
-                return true;
-            } else {
-                if (depthptr) {
-                    *depthptr = -1;
-                }
-                return false;
-            }
+        curr = get_next_char(self);
+        if (curr < 0) {
+            return ELTN_TOKEN_INVALID;
+        }
+        if (curr == '\r') {
+            continue;
+        }
+        token_buffer_append(self, curr);
+        if (curr == ']'
+            && token_buffer_ends_with_long_bracket(self, open, level)) {
+            return token;
         }
     }
-    return false;
 }
 
-static bool token_buffer_ends_with_long_bracket(ELTN_Lexer* self, size_t depth) {
-    size_t bufidx = 0;
-    size_t buflen = depth + 4;
-    char bracket[buflen];
+/*
+ * Skip the rest of a short comment, up to and including the newline.
+ */
+static ELTN_Token skip_comment(ELTN_Lexer* self, int32_t curr) {
+    while (curr >= 0 && curr != '\n') {
+        if (can_advance(self)) {
+            advance_to(self, ELTN_scan_line_end(self->cursor, self->limit));
+        }
+        curr = get_next_char(self);
+    }
+    return ELTN_TOKEN_COMMENT;
+}
+
+/*
+ * Skip the body of a long comment up to and including the closing
+ * bracket of `level`, without keeping any of it.
+ */
+static ELTN_Token skip_long_comment(ELTN_Lexer* self, size_t level) {
+    int32_t curr = get_next_char(self);
+
+    for (;;) {
+        size_t equals = 0;
 
-    if (token_buffer_ends_with(self, "]")) {
-        bracket[0] = ']';
-        bufidx++;
-        for (int i = 0; i < depth; i++) {
-            bracket[bufidx] = '=';
-            bufidx++;
+        while (curr != ']') {
+            if (curr < 0) {
+                return ELTN_TOKEN_INVALID;
+            }
+            if (can_advance(self)) {
+                const char8_t* end = memchr(self->cursor, ']',
+                                            self->limit - self->cursor);
+
+                advance_to(self, (end != NULL) ? end : self->limit);
+            }
+            curr = get_next_char(self);
         }
-        bracket[bufidx] = ']';
-        bufidx++;
-        bracket[bufidx] = '\0';
-        if (token_buffer_ends_with(self, bracket)) {
-            return true;
+        curr = get_next_char(self);
+        while (curr == '=') {
+            equals++;
+            curr = get_next_char(self);
+        }
+        if (curr == ']' && equals == level) {
+            return ELTN_TOKEN_LONG_COMMENT;
         }
     }
-    return false;
 }
 
 static ELTN_Token consume_until_end_of_comment(ELTN_Lexer* self) {
     int32_t curr = get_next_char(self);
-    bool is_long_start = false;
-    bool is_long_end = false;
-    ssize_t depth = 0;
 
-    while (!self->eos) {
+    if (curr == '[') {
+        ssize_t level;
+
+        token_buffer_append(self, curr);
+        level = read_long_bracket(self, &curr);
+        if (level >= 0 && self->skip_comments) {
+            return skip_long_comment(self, level);
+        } else if (level >= 0) {
+            return consume_long_bracket(self, level, ELTN_TOKEN_LONG_COMMENT);
+        }
+    }
+    if (self->skip_comments) {
+        return skip_comment(self, curr);
+    }
+
+    while (curr >= 0) {
         if (curr != '\r') {
             token_buffer_append(self, curr);
         }
-        is_long_start = is_long_start || in_long_bracket(self, "--[", &depth);
-        if (!is_long_start && curr == '\n') {
+        if (curr == '\n') {
             break;
         }
-        if (is_long_start && token_buffer_ends_with_long_bracket(self, depth)) {
-            is_long_end = true;
-            break;
+        if (can_advance(self)) {
+            token_buffer_append_text(self, advance_to(self,
+                ELTN_scan_line_end(self->cursor, self->limit)));
         }
         curr = get_next_char(self);
     }
-    if (is_long_start) {
-        return is_long_end ? ELTN_TOKEN_LONG_COMMENT : ELTN_TOKEN_INVALID;
-    } else {
-        return ELTN_TOKEN_COMMENT;
-    }
+    return ELTN_TOKEN_COMMENT;
 }
 
 static ELTN_Token parse_long_string(ELTN_Lexer* self) {
-    bool past_open = token_buffer_starts_with(self, "[[");
-    bool past_close = token_buffer_ends_with(self, "]]");
-    int32_t curr = get_next_char(self);
-    ssize_t depth = 0;
+    int32_t curr;
+    ssize_t level = read_long_bracket(self, &curr);
 
-    while (!self->eos && !past_close) {
-        if (curr != '\r') {
+    if (level < 0) {
+        if (curr >= 0) {
             token_buffer_append(self, curr);
         }
-        past_open = past_open || in_long_bracket(self, "[", &depth);
-        if (!past_open && (curr != '=' || depth < 0)) {
-            return ELTN_TOKEN_INVALID;
-        }
-        if (past_open && token_buffer_ends_with_long_bracket(self, depth)) {
-            past_close = true;
-            break;
-        }
-        curr = get_next_char(self);
+        return ELTN_TOKEN_INVALID;
     }
-    return past_close ? ELTN_TOKEN_LONG_STRING : ELTN_TOKEN_INVALID;
+    return consume_long_bracket(self, level, ELTN_TOKEN_LONG_STRING);
+}
+
+/*
+ * Whether a sign may come next in a numeral, i.e. the token so far ends
+ * with an exponent marker: 'e' if decimal, 'p' if hexadecimal.
+ */
+static bool number_takes_sign(ELTN_Lexer* self) {
+    const char8_t* text = token_text(self);
+    const size_t len = token_length(self);
+    const size_t start = (text[0] == '-') ? 1 : 0;
+    const bool hex = len >= start + 2 && text[start] == '0'
+        && (text[start + 1] == 'x' || text[start + 1] == 'X');
+    const char8_t last = text[len - 1];
+
+    return hex ? (last == 'p' || last == 'P') : (last == 'e' || last == 'E');
 }
 
 static ELTN_Token parse_number(ELTN_Lexer* self, char32_t curr) {
+    const uint16_t mask = ELTN_CLASS_NUMBER_PART | ELTN_CLASS_SIGN;
+    int32_t tmp;
+
     /*
-     * This is a very cheap way to parse a number, but I'm short on time.
+     * Take digits, letters and points in bulk, and signs only after
+     * an exponent marker.
      */
-    char* ptr = NULL;
-    char32_t tmp = get_next_char(self);
-    double test;
+    for (;;) {
+        if (can_advance(self)) {
+            const char8_t* ptr = self->cursor;
 
-    while (ELTN_is_number_part(tmp)) {
-        token_buffer_append(self, tmp);
+            while (ptr < self->limit
+                   && (ELTN_CHAR_CLASS[*ptr] & mask) == ELTN_CLASS_NUMBER_PART) {
+                ptr++;
+            }
+            token_buffer_append_from(self, advance_to(self, ptr));
+        }
         tmp = get_next_char(self);
+        if (!ELTN_CHAR_IS(tmp, ELTN_CLASS_NUMBER_PART)
+            || (ELTN_CHAR_IS(tmp, ELTN_CLASS_SIGN) && !number_takes_sign(self))) {
+            break;
+        }
+        token_buffer_append(self, tmp);
     }
     self->pushback = true;
 
-    test = strtod((const char *)self->token_buffer, &ptr);
-    if (!isnan(test) && !isinf(test)
-        && ptr == (char *)self->token_buffer_tail) {
+    switch (ELTN_parse_numeral((const char *)token_text(self),
+                               token_length(self),
+                               &(self->integer), &(self->number))) {
+    case ELTN_NUMERAL_INTEGER:
+        return ELTN_TOKEN_INTEGER;
+    case ELTN_NUMERAL_FLOAT:
         return ELTN_TOKEN_NUMBER;
+    default:
+        return ELTN_TOKEN_INVALID;
     }
+}
 
-    return ELTN_TOKEN_INVALID;
+/*
+ * How many bytes of input the lexer has read, not counting a character
+ * pushed back.
+ */
+static size_t input_offset(ELTN_Lexer* self) {
+    size_t offset = self->released + self->held + (self->cursor - self->span);
+
+    return (self->pushback && !self->eos) ? offset - 1 : offset;
 }
 
-ELTN_Token ELTN_Lexer_next_token(ELTN_Lexer* self, int* lineptr, int* colptr) {
+/*
+ * Bring the line count up to `end` in the current span.
+ */
+static void count_lines(ELTN_Lexer* self, const char8_t* end) {
+    const size_t base = self->released + self->held;
+    const char8_t* start;
+    const char8_t* after = NULL;
+
+    if (self->span == NULL || base + (end - self->span) <= self->line_counted) {
+        return;
+    }
+    start = (self->line_counted > base)
+        ? self->span + (self->line_counted - base) : self->span;
+    self->line += ELTN_scan_count_lines(start, end, &after);
+    if (after != NULL) {
+        self->line_start = base + (after - self->span);
+    }
+    self->line_counted = base + (end - self->span);
+}
+
+/*
+ * Work out the line and column of the current token, which starts in
+ * the current span unless it has been located already.
+ */
+static void locate_token(ELTN_Lexer* self) {
+    const size_t base = self->released + self->held;
+
+    if (self->token_located) {
+        return;
+    }
+    if (self->span != NULL && self->token_offset > base) {
+        count_lines(self, self->span + (self->token_offset - base));
+    }
+    self->token_line = self->line;
+    self->token_column = 1 + (int)(self->token_offset - self->line_start);
+    self->token_located = true;
+}
+
+static void token_position(ELTN_Lexer* self, int* lineptr, int* colptr) {
+    if (lineptr == NULL && colptr == NULL) {
+        return;
+    }
+    locate_token(self);
+    if (lineptr) {
+        *lineptr = self->token_line;
+    }
+    if (colptr) {
+        *colptr = self->token_column;
+    }
+}
+
+static ELTN_Token scan_token(ELTN_Lexer* self, int* lineptr, int* colptr) {
     int32_t curr = get_next_char(self);
 
     token_buffer_clear(self);
+    self->token_located = true;
 
     if (curr < 0 || self->eos) {
-        if (lineptr) {
-            *lineptr = self->line;
-        }
-        if (colptr) {
-            *colptr = self->column;
-        }
+        self->token_offset = input_offset(self);
+        self->token_located = false;
+        token_position(self, lineptr, colptr);
         return ELTN_TOKEN_EOF;
     }
 
-    while (ELTN_is_space(curr)) {
+    while (ELTN_CHAR_IS(curr, ELTN_CLASS_SPACE)) {
+        if (can_advance(self)) {
+            advance_to(self, ELTN_scan_non_blank(self->cursor, self->limit));
+        }
         curr = get_next_char(self);
     }
 
     token_buffer_append(self, curr);
-
-    if (lineptr) {
-        *lineptr = self->line;
-    }
-    if (colptr) {
-        *colptr = self->column;
-    }
+    self->token_offset = input_offset(self) - ((curr < 0) ? 0 : 1);
+    self->token_located = false;
+    token_position(self, lineptr, colptr);
 
     switch (curr) {
     case '[':
@@ -406,7 +1018,7 @@ ELTN_Token ELTN_Lexer_next_token(ELTN_Lexer* self, int* lineptr, int* colptr) {
          */
         curr = get_next_char(self);
         if (curr == '[' || curr == '=') {
-            token_buffer_append(self, curr);
+            self->pushback = true;
             return parse_long_string(self);
         }
         self->pushback = true;
@@ -446,7 +1058,7 @@ ELTN_Token ELTN_Lexer_next_token(ELTN_Lexer* self, int* lineptr, int* colptr) {
         if (curr == '-') {
             token_buffer_append(self, curr);
             return consume_until_end_of_comment(self);
-        } else if (ELTN_is_digit(curr) || curr == '.') {
+        } else if (ELTN_CHAR_IS(curr, ELTN_CLASS_DIGIT) || curr == '.') {
             token_buffer_append(self, curr);
             return parse_number(self, curr);
         } else {
@@ -463,10 +1075,12 @@ ELTN_Token ELTN_Lexer_next_token(ELTN_Lexer* self, int* lineptr, int* colptr) {
         /*
            identifier, "true", "false", "nil", or illegal keyword 
          */
-        if (ELTN_is_name_start(curr)) {
+        if (ELTN_CHAR_IS(curr, ELTN_CLASS_NAME_START)) {
+            token_buffer_append_run(self, ELTN_CLASS_NAME_PART, true);
             curr = get_next_char(self);
-            while (!self->eos && ELTN_is_name_part(curr)) {
+            while (!self->eos && ELTN_CHAR_IS(curr, ELTN_CLASS_NAME_PART)) {
                 token_buffer_append(self, curr);
+                token_buffer_append_run(self, ELTN_CLASS_NAME_PART, true);
                 curr = get_next_char(self);
             }
 
@@ -475,18 +1089,31 @@ ELTN_Token ELTN_Lexer_next_token(ELTN_Lexer* self, int* lineptr, int* colptr) {
              */
             self->pushback = true;
 
-            if (token_buffer_equals(self, "true")) {
-                return ELTN_TOKEN_BOOLEAN_TRUE;
-            } else if (token_buffer_equals(self, "false")) {
-                return ELTN_TOKEN_BOOLEAN_FALSE;
-            } else if (token_buffer_equals(self, "nil")) {
-                return ELTN_TOKEN_NIL;
-            } else if (token_buffer_is_keyword(self)) {
-                return ELTN_TOKEN_INVALID;
-            } else {
-                return ELTN_TOKEN_NAME;
-            }
+            return token_buffer_name(self);
         }
         return (curr < 0) ? ELTN_TOKEN_EOF : ELTN_TOKEN_INVALID;
     }
 }
+
+ELTN_Token ELTN_Lexer_next_token(ELTN_Lexer* self, int* lineptr, int* colptr) {
+    ELTN_Token result = scan_token(self, lineptr, colptr);
+
+    if (self->errcode != ELTN_OK) {
+        return ELTN_TOKEN_ERROR;
+    }
+    return self->dry ? ELTN_TOKEN_NEED_MORE : result;
+}
+
+void ELTN_Lexer_token_extent(ELTN_Lexer* self, size_t* offsetptr,
+                             size_t* lenptr) {
+    if (offsetptr) {
+        (*offsetptr) = self->token_offset;
+    }
+    if (lenptr) {
+        (*lenptr) = input_offset(self) - self->token_offset;
+    }
+}
+
+void ELTN_Lexer_token_position(ELTN_Lexer* self, int* lineptr, int* colptr) {
+    token_position(self, lineptr, colptr);
+}
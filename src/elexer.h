@@ -27,40 +27,76 @@
 #include "eltn.h"
 #include "convert.h"
 
-typedef int32_t(*ELTN_Char_Source) (void* state, bool consume);
-
-typedef enum ELTN_Token {
-    ELTN_TOKEN_ERROR = -1,
-    ELTN_TOKEN_INVALID = 0,
-    ELTN_TOKEN_CURLY_OPEN,
-    ELTN_TOKEN_CURLY_CLOSE,
-    ELTN_TOKEN_SQUARE_OPEN,
-    ELTN_TOKEN_SQUARE_CLOSE,
-    ELTN_TOKEN_SEMICOLON,
-    ELTN_TOKEN_COMMA,
-    ELTN_TOKEN_EQUALS,
-    ELTN_TOKEN_NAME,
-    ELTN_TOKEN_STRING,
-    ELTN_TOKEN_LONG_STRING,
-    ELTN_TOKEN_NUMBER,
-    ELTN_TOKEN_INTEGER,
-    ELTN_TOKEN_BOOLEAN_TRUE,
-    ELTN_TOKEN_BOOLEAN_FALSE,
-    ELTN_TOKEN_NIL,
-    ELTN_TOKEN_COMMENT,
-    ELTN_TOKEN_LONG_COMMENT,
-    ELTN_TOKEN_EOF
-} ELTN_Token;
+/**
+ * Hands the lexer its next contiguous span of input.  The lexer first
+ * gives back the first `release` bytes of what it was handed before; the
+ * new span starts `offset` bytes past the first byte not yet released.
+ * Returns the length of the span, 0 at the end of input, or -1 if no more
+ * input is available yet.
+ */
+typedef ssize_t(*ELTN_Span_Source) (void* state, size_t release,
+                                    size_t offset, const char8_t** spanptr);
 
 typedef struct ELTN_Lexer ELTN_Lexer;
 
 ELTN_Lexer* ELTN_Lexer_new_with_pool(ELTN_Pool * pool);
 
-void ELTN_Lexer_set_char_source(ELTN_Lexer * self, ELTN_Char_Source fcn,
+void ELTN_Lexer_set_span_source(ELTN_Lexer * self, ELTN_Span_Source fcn,
                                 void* state);
 
+void ELTN_Lexer_set_max_token_length(ELTN_Lexer * self, size_t len);
+
+void ELTN_Lexer_set_max_input(ELTN_Lexer * self, size_t len);
+
+void ELTN_Lexer_set_incremental(ELTN_Lexer * self, bool b);
+
+/*
+ * If `b`, the text of a comment is skipped rather than kept, and the
+ * token string of an ELTN_TOKEN_COMMENT or ELTN_TOKEN_LONG_COMMENT is
+ * just as far as its opening "--" or "--[==[".
+ */
+void ELTN_Lexer_set_skip_comments(ELTN_Lexer * self, bool b);
+
+void ELTN_Lexer_mark(ELTN_Lexer * self);
+
+void ELTN_Lexer_unmark(ELTN_Lexer * self);
+
+void ELTN_Lexer_rewind(ELTN_Lexer * self);
+
 ELTN_Token ELTN_Lexer_next_token(ELTN_Lexer * self, int* lineptr, int* colptr);
 
+ELTN_Error ELTN_Lexer_error(ELTN_Lexer * self);
+
+/*
+ * The current token's text, valid until the next call to
+ * ELTN_Lexer_next_token().  It is not necessarily NUL-terminated.
+ */
+void ELTN_Lexer_token_view(ELTN_Lexer * self, const char** strptr,
+                           size_t* lenptr);
+
+/*
+ * The line and column where the current token starts, both from 1.
+ * They are worked out only when asked for, here or by passing
+ * ELTN_Lexer_next_token() non-NULL pointers.
+ */
+void ELTN_Lexer_token_position(ELTN_Lexer * self, int* lineptr, int* colptr);
+
+/*
+ * Where the current token lies in the input, as an offset in bytes from
+ * the start of input and the number of input bytes it spans, including
+ * any quotes, brackets, and escapes.
+ */
+void ELTN_Lexer_token_extent(ELTN_Lexer * self, size_t* offsetptr,
+                             size_t* lenptr);
+
+/*
+ * The value of the current token, if it is an ELTN_TOKEN_INTEGER or
+ * ELTN_TOKEN_NUMBER; an integer's number is the same value as a double.
+ */
+int64_t ELTN_Lexer_integer(ELTN_Lexer * self);
+
+double ELTN_Lexer_number(ELTN_Lexer * self);
+
 void ELTN_Lexer_token_string(ELTN_Lexer * self, char** strptr, size_t* lenptr);
 
 void ELTN_Lexer_free(ELTN_Lexer * self);
@@ -33,6 +33,10 @@
 #endif
 #include <sys/types.h>
 
+#if defined(_WIN32) && !defined(ELTN_NO_POSIX)
+#define ELTN_NO_POSIX
+#endif
+
 /**
  * @file
  * @brief The main header file for the ELTN parser and emitter.
@@ -73,10 +77,9 @@ typedef struct ELTN_Parser ELTN_Parser;
  * control of text fed into the parser.  Functions on it allow control
  * of the parser's buffer and feeding text directly into the buffer.
  *
- * The buffer is currently not designed for multi-threaded operation.
- * A future version *may* add support for one or more threads feeding
- * the buffer with ELTN_Buffer_write() calls while one thread runs the
- * parser.
+ * By default the buffer is not designed for multi-threaded operation.
+ * After ELTN_Buffer_set_synchronized() one or more threads may feed the
+ * buffer with ELTN_Buffer_write() calls while one thread runs the parser.
  */
 typedef struct ELTN_Buffer ELTN_Buffer;
 
@@ -125,6 +128,38 @@ typedef void* (*ELTN_Alloc)(void* state, void* ptr, size_t size);
  */
 typedef int (*ELTN_Reader)(void* state, char** strptr, size_t* sizeptr);
 
+/**
+ * A callback the {@link ELTN_Parser} uses to return a chunk lent by an
+ * {@link ELTN_Lender} once it has finished reading it.
+ *
+ * @param state (in) the state passed to the lender
+ * @param text (in) the chunk of text lent
+ * @param size (in) the size of the chunk of text lent
+ */
+typedef void (*ELTN_Release)(void* state, const char* text, size_t size);
+
+/**
+ * A callback the {@link ELTN_Parser} uses to read an ELTN document in place,
+ * one chunk at a time.  Unlike an {@link ELTN_Reader}, the lender keeps
+ * ownership of each chunk; the parser reads it without copying and returns
+ * it through `*releaseptr`, if not NULL, before asking for the next one.
+ *
+ * @param state (in) a reference used to read data, such as a socket
+ * @param strptr (out) a pointer to the chunk of text lent,
+ *               or NULL if at end of the document.
+ * @param sizeptr (out) a pointer to the size of the chunk lent,
+ *                or to 0 at the end of the document.
+ * @param releaseptr (out) a pointer to a function to return the chunk,
+ *                   or to NULL if the chunk needs no release.
+ *
+ * @return 0 under normal circumstances;
+ *         the value of `errno` at the time of a system error,
+ *         or a negative value in case of an application error.
+ *         Any error stops the parser with `ELTN_ERR_READ`.
+ */
+typedef int (*ELTN_Lender)(void* state, const char** strptr, size_t* sizeptr,
+                           ELTN_Release* releaseptr);
+
 /**
  * A callback the {@link ELTN_Emitter} uses to write an ELTN document.
  * During normal operation, the function should return
@@ -162,7 +197,8 @@ typedef enum ELTN_Event {
     ELTN_VALUE_NIL,
     ELTN_TABLE_START,
     ELTN_TABLE_END,
-    ELTN_STREAM_END
+    ELTN_STREAM_END,
+    ELTN_NEED_MORE_INPUT
 } ELTN_Event;
 
 /**
@@ -198,7 +234,9 @@ typedef enum ELTN_Error {
     ELTN_ERR_STREAM_END,
     ELTN_ERR_UNEXPECTED_TOKEN,
     ELTN_ERR_INVALID_TOKEN,
-    ELTN_ERR_DUPLICATE_KEY
+    ELTN_ERR_DUPLICATE_KEY,
+    ELTN_ERR_LIMIT_EXCEEDED,
+    ELTN_ERR_READ
 } ELTN_Error;
 
 /**
@@ -255,6 +293,149 @@ ELTN_API bool ELTN_Parser_include_comments(ELTN_Parser * parser);
  */
 ELTN_API void ELTN_Parser_set_include_comments(ELTN_Parser * parser, bool b);
 
+/**
+ * Indicates whether the parser gives every key it meets an ID, as
+ * returned by ELTN_Parser_key_id().  If not, only keys added with
+ * ELTN_Parser_intern_key() have IDs.  The default is `false`.
+ *
+ * @param parser the parser
+ *
+ * @return 'true' if the parser interns all keys, else false.
+ */
+ELTN_API bool ELTN_Parser_intern_keys(ELTN_Parser * parser);
+
+/**
+ * Sets whether the parser gives every key it meets an ID.
+ *
+ * @param parser the parser
+ * @param b new value of ELTN_Parser_intern_keys().
+ */
+ELTN_API void ELTN_Parser_set_intern_keys(ELTN_Parser * parser, bool b);
+
+/**
+ * Gives a key a stable ID before parsing, so consumers can recognize it
+ * by ELTN_Parser_key_id() instead of comparing strings.  IDs count up
+ * from 0 in the order keys are added; adding a key again returns the ID
+ * it already has.
+ *
+ * @param parser the parser
+ * @param key the key's bytes, unquoted and unescaped
+ * @param len the number of bytes in `key`
+ *
+ * @return the key's ID, or negative if out of memory.
+ */
+ELTN_API int ELTN_Parser_intern_key(ELTN_Parser * parser, const char* key,
+                                    size_t len);
+
+/**
+ * The seed the parser passes to ELTN_hash() to hash keys for
+ * ELTN_Parser_key_hash().  The default is 0.
+ *
+ * @param parser the parser
+ *
+ * @return the hash seed.
+ */
+ELTN_API uint64_t ELTN_Parser_hash_seed(ELTN_Parser * parser);
+
+/**
+ * Sets the seed the parser passes to ELTN_hash() to hash keys.
+ * Consumers whose hash tables face untrusted documents should pick a
+ * random seed, so an attacker can't choose keys that collide.
+ *
+ * @param parser the parser
+ * @param seed new value of ELTN_Parser_hash_seed().
+ */
+ELTN_API void ELTN_Parser_set_hash_seed(ELTN_Parser * parser, uint64_t seed);
+
+/**
+ * Whether the parser suspends when its buffer runs dry.
+ *
+ * @param parser the parser
+ *
+ * @return whether the parser is incremental.
+ */
+ELTN_API bool ELTN_Parser_is_incremental(ELTN_Parser * parser);
+
+/**
+ * Sets whether the parser suspends when its buffer runs dry.
+ *
+ * An incremental parser fed through `ELTN_Buffer_write()` does not treat
+ * an empty buffer as the end of the document until the buffer is closed.
+ * Instead `ELTN_Parser_next()` reports `ELTN_NEED_MORE_INPUT` and leaves
+ * the parser where it was before the call; once the caller has written
+ * more text, the next call to `ELTN_Parser_next()` picks up from there.
+ *
+ * The mode has no effect on synchronized buffers, which wait for input,
+ * nor on buffers read through an `ELTN_Reader` or `ELTN_Lender`.
+ *
+ * @param parser the parser
+ * @param b whether the parser is incremental.
+ */
+ELTN_API void ELTN_Parser_set_incremental(ELTN_Parser * parser, bool b);
+
+/**
+ * The longest token, in bytes, the parser will accept; 0 if unlimited.
+ *
+ * @param parser the parser
+ *
+ * @return the maximum token length.
+ */
+ELTN_API size_t ELTN_Parser_max_token_length(ELTN_Parser * parser);
+
+/**
+ * Sets the longest token, in bytes, the parser will accept.
+ * A longer token, such as a huge string, stops the parser with an
+ * `ELTN_ERR_LIMIT_EXCEEDED` error before it buffers more than `len` bytes.
+ *
+ * @param parser the parser
+ * @param len the maximum token length, or 0 if unlimited.
+ */
+ELTN_API void ELTN_Parser_set_max_token_length(ELTN_Parser * parser,
+                                               size_t len);
+
+/**
+ * The deepest nesting of tables the parser will accept; 0 if unlimited.
+ *
+ * @param parser the parser
+ *
+ * @return the maximum depth.
+ */
+ELTN_API unsigned int ELTN_Parser_max_depth(ELTN_Parser * parser);
+
+/**
+ * Sets the deepest nesting of tables the parser will accept.
+ * A table nested deeper stops the parser with an `ELTN_ERR_LIMIT_EXCEEDED`
+ * error.
+ *
+ * @param parser the parser
+ * @param depth the maximum depth, or 0 if unlimited.
+ */
+ELTN_API void ELTN_Parser_set_max_depth(ELTN_Parser * parser,
+                                        unsigned int depth);
+
+/**
+ * The longest document, in bytes, the parser will accept; 0 if unlimited.
+ *
+ * @param parser the parser
+ *
+ * @return the maximum document size.
+ */
+ELTN_API size_t ELTN_Parser_max_document_size(ELTN_Parser * parser);
+
+/**
+ * Sets the longest document, in bytes, the parser will accept.
+ * The parser stops with an `ELTN_ERR_LIMIT_EXCEEDED` error as soon as it
+ * reads past the limit.
+ *
+ * To cap the memory the parser's buffer uses, see
+ * `ELTN_Buffer_set_max_capacity()`.
+ *
+ * @param parser the parser
+ * @param size the maximum document size, or 0 if unlimited.
+ */
+ELTN_API void ELTN_Parser_set_max_document_size(ELTN_Parser * parser,
+                                                size_t size);
+
 /**
  * The instance that handles all the parser's text input.
  * The parser completely manages its buffer.
@@ -277,6 +458,21 @@ ELTN_API ELTN_Buffer* ELTN_Parser_buffer(ELTN_Parser * parser);
 ELTN_API ssize_t ELTN_Parser_read(ELTN_Parser * parser, ELTN_Reader reader,
                                   void* state);
 
+/**
+ * Set a lender function and borrow the first chunk of the text to be parsed.
+ * The parser reads each chunk in place, with no allocation or copy, and
+ * releases it once read.
+ * The parser's buffer must be empty and have no reader function.
+ *
+ * @param parser the parser
+ * @param lender a function to lend more bytes from a source
+ * @param state  a state variable passed to `lender`, possibly its source.
+ *
+ * @return the initial number of bytes borrowed, or -1 if error.
+ */
+ELTN_API ssize_t ELTN_Parser_read_lent(ELTN_Parser * parser,
+                                       ELTN_Lender lender, void* state);
+
 /**
  * Set a reader function and read the first chunk of the text to be parsed.
  * This function assumes the string contains an entire ELTN document.
@@ -290,6 +486,23 @@ ELTN_API ssize_t ELTN_Parser_read(ELTN_Parser * parser, ELTN_Reader reader,
 ELTN_API ssize_t ELTN_Parser_read_string(ELTN_Parser * parser, const char* str,
                                          size_t len);
 
+/**
+ * Parse a string in place, without copying it into the parser's buffer.
+ * Like ELTN_Parser_read_string() this assumes the string contains an entire
+ * ELTN document, but the parser reads directly from the caller's memory.
+ *
+ * The caller retains ownership of @p str, and must neither modify nor free
+ * it until ELTN_Parser_has_next() returns `false` or the parser is freed.
+ *
+ * @param parser the parser
+ * @param str the string to be parsed.
+ * @param len the length of the string.
+ *
+ * @return the total number of bytes in `str`, or -1 if error.
+ */
+ELTN_API ssize_t ELTN_Parser_read_string_in_place(ELTN_Parser * parser,
+                                                  const char* str, size_t len);
+
 #ifndef ELTN_NO_STDIO
 
 /**
@@ -305,8 +518,41 @@ ELTN_API ssize_t ELTN_Parser_read_file(ELTN_Parser * parser, FILE * fp);
 
 #endif
 
+#ifndef ELTN_NO_POSIX
+
+/**
+ * Read an entire ELTN document from a file descriptor.
+ * A regular file is mapped into memory and parsed in place;
+ * anything else, e.g. a pipe or socket, is read in large blocks,
+ * and a failed read stops the parser with `ELTN_ERR_READ`.
+ * The caller retains ownership of @p fd and must keep it open until
+ * the parser is freed.
+ *
+ * @param parser the parser
+ * @param fd an open file descriptor
+ *
+ * @return the initial number of bytes available, or -1 if error.
+ */
+ELTN_API ssize_t ELTN_Parser_read_fd(ELTN_Parser * parser, int fd);
+
+/**
+ * Open and read an entire ELTN document from the file at @p path,
+ * as if by ELTN_Parser_read_fd().
+ * The parser closes the file when it no longer needs it.
+ *
+ * @param parser the parser
+ * @param path the path of the ELTN file to be read.
+ *
+ * @return the initial number of bytes available, or -1 if error.
+ */
+ELTN_API ssize_t ELTN_Parser_read_path(ELTN_Parser * parser, const char* path);
+
+#endif
+
 /**
  * Whether the parser has other events to process.
+ * This includes `ELTN_NEED_MORE_INPUT`, after which the caller should
+ * supply more input before calling `ELTN_Parser_next()` again.
  *
  * @param parser the parser.
  *
@@ -330,6 +576,44 @@ ELTN_API void ELTN_Parser_next(ELTN_Parser * parser);
  */
 ELTN_API ELTN_Event ELTN_Parser_event(ELTN_Parser * parser);
 
+/**
+ * The ID of the definition name or key of the current event, if it is
+ * an `ELTN_DEF_NAME` or `ELTN_KEY_STRING` and the key has one.
+ * While it does, ELTN_Parser_string_view() points to the parser's own
+ * copy of the key, which lasts as long as the parser.
+ *
+ * @param parser the parser.
+ *
+ * @return the key's ID, or negative if it has none.
+ */
+ELTN_API int ELTN_Parser_key_id(ELTN_Parser * parser);
+
+/**
+ * The hash of the definition name or key of the current event, if it is
+ * an `ELTN_DEF_NAME` or `ELTN_KEY_STRING`: the value of ELTN_hash() for
+ * the bytes ELTN_Parser_string_view() returns, with the seed from
+ * ELTN_Parser_hash_seed().  The parser hashes each key at most once, so
+ * consumers can insert keys into their own hash tables without hashing
+ * them again.
+ *
+ * @param parser the parser.
+ *
+ * @return the key's hash, or 0 for other events or if out of memory.
+ */
+ELTN_API uint64_t ELTN_Parser_key_hash(ELTN_Parser * parser);
+
+/**
+ * Points to the key with ID `id`.  The key belongs to the parser and lasts
+ * as long as the parser.
+ *
+ * @param parser the parser.
+ * @param id the key's ID.
+ * @param strptr a pointer to receive the key, or NULL if no key has that ID.
+ * @param lenptr a pointer to receive the length of the key.
+ */
+ELTN_API void ELTN_Parser_interned_key(ELTN_Parser * parser, int id,
+                                       const char** strptr, size_t* lenptr);
+
 /**
  * The depth of nested tables in the document after the current event.
  * It increases by one with every `ELTN_TABLE_START` and decreases by one
@@ -378,6 +662,10 @@ ELTN_API void ELTN_Parser_text(ELTN_Parser * parser, char** strptr,
  * or nil of the current definition, key or value.
  * The copy may be freed by `free()`.
  *
+ * Strings are only unquoted and unescaped when their value is first asked
+ * for, so events whose values are never read cost no decoding.  If that
+ * runs out of memory, `*strptr` is set to NULL.
+ *
  * @param parser the parser.
  * @param strptr a pointer to receive a copy of the string.
  * @param lenptr a pointer to receive the length of the string.
@@ -385,6 +673,63 @@ ELTN_API void ELTN_Parser_text(ELTN_Parser * parser, char** strptr,
 ELTN_API void ELTN_Parser_string(ELTN_Parser * parser, char** strptr,
                                  size_t* lenptr);
 
+/**
+ * Points to the text of the current event, as {@link ELTN_Parser_text}
+ * would copy it, without copying it.  The text belongs to the parser;
+ * it is valid until the next call to `ELTN_Parser_next()`, and is not
+ * necessarily null-terminated.
+ *
+ * @param parser the parser.
+ * @param strptr a pointer to receive the start of the text.
+ * @param lenptr a pointer to receive the length of the text.
+ */
+ELTN_API void ELTN_Parser_text_view(ELTN_Parser * parser, const char** strptr,
+                                    size_t* lenptr);
+
+/**
+ * Points to the string value of the current event, as
+ * {@link ELTN_Parser_string} would copy it, without copying it.
+ * The value belongs to the parser; it is valid until the next call to
+ * `ELTN_Parser_next()`, and is not necessarily null-terminated.
+ * If decoding the value runs out of memory, `*strptr` is set to NULL.
+ *
+ * @param parser the parser.
+ * @param strptr a pointer to receive the start of the string.
+ * @param lenptr a pointer to receive the length of the string.
+ */
+ELTN_API void ELTN_Parser_string_view(ELTN_Parser * parser,
+                                      const char** strptr, size_t* lenptr);
+
+/**
+ * Copies the text of the current event into caller-owned storage.
+ * At most @p cap bytes are copied, followed by a null byte if there is
+ * room for it.
+ *
+ * @param parser the parser.
+ * @param buf the buffer to receive the text.
+ * @param cap the size of @p buf in bytes.
+ *
+ * @return the full length of the text; if it is @p cap or more, the copy
+ *         is not null-terminated, and if more, it is truncated.
+ */
+ELTN_API size_t ELTN_Parser_text_copy_into(ELTN_Parser * parser, char* buf,
+                                           size_t cap);
+
+/**
+ * Copies the string value of the current event into caller-owned storage.
+ * At most @p cap bytes are copied, followed by a null byte if there is
+ * room for it.
+ *
+ * @param parser the parser.
+ * @param buf the buffer to receive the string.
+ * @param cap the size of @p buf in bytes.
+ *
+ * @return the full length of the string; if it is @p cap or more, the copy
+ *         is not null-terminated, and if more, it is truncated.
+ */
+ELTN_API size_t ELTN_Parser_string_copy_into(ELTN_Parser * parser, char* buf,
+                                             size_t cap);
+
 /**
  * Returns the numeric value associated with the current event.
  * Results are undefined outside `ELTN_KEY_NUMBER`, `ELTN_KEY_INTEGER`,
@@ -475,6 +820,83 @@ ELTN_API size_t ELTN_Buffer_capacity(ELTN_Buffer * buffer);
  */
 ELTN_API bool ELTN_Buffer_set_capacity(ELTN_Buffer * buffer, size_t newcap);
 
+/**
+ * The most bytes this object may ever store at once, or 0 if unlimited
+ * (the default).
+ *
+ * @param buffer the buffer
+ *
+ * @return number of bytes.
+ */
+ELTN_API size_t ELTN_Buffer_max_capacity(ELTN_Buffer * buffer);
+
+/**
+ * Set the most bytes this object may ever store at once, so that memory
+ * use stays flat however large the document.  Once the buffer reaches
+ * this size ELTN_Buffer_write() blocks until the parser catches up if the
+ * buffer is synchronized, or fails if it is not.
+ * The limit must be at least two bytes, and no lower than the bytes
+ * the buffer currently holds.
+ *
+ * @param buffer the buffer
+ * @param maxcap the maximum buffer size, or 0 for no limit.
+ *
+ * @return whether the limit changed.
+ */
+ELTN_API bool ELTN_Buffer_set_max_capacity(ELTN_Buffer * buffer,
+                                           size_t maxcap);
+
+/**
+ * Whether the buffer is safe to share between a producer thread and the
+ * parser's thread.
+ *
+ * @param buffer the buffer
+ *
+ * @return whether the buffer is synchronized.
+ */
+ELTN_API bool ELTN_Buffer_is_synchronized(ELTN_Buffer * buffer);
+
+/**
+ * Make the buffer safe to share between threads that write to it and the
+ * thread that parses it.  When synchronized, the parser waits for more
+ * text instead of reaching the end of the document until the buffer is
+ * closed, and writers wait for room if the buffer has a maximum capacity.
+ * Call this before any other thread uses the buffer.
+ * Not available if the library was compiled with `ELTN_NO_THREADS`.
+ *
+ * @param buffer the buffer
+ * @param b whether the buffer is synchronized.
+ *
+ * @return whether the setting took effect.
+ */
+ELTN_API bool ELTN_Buffer_set_synchronized(ELTN_Buffer * buffer, bool b);
+
+/**
+ * Whether the buffer maps its ring twice, back to back, in virtual memory.
+ *
+ * @param buffer the buffer
+ *
+ * @return whether the buffer is mirrored.
+ */
+ELTN_API bool ELTN_Buffer_is_mirrored(ELTN_Buffer * buffer);
+
+/**
+ * Map the buffer's ring twice, back to back, so that unread text is always
+ * contiguous in memory and writes never split at the end of the ring.
+ * A mirrored ring comes straight from the operating system rather than
+ * the buffer's pool, and its capacity is a whole number of pages.
+ * The buffer must be empty.
+ *
+ * Only supported on Linux; elsewhere, or if built with `ELTN_NO_MIRROR`,
+ * this fails for `true`.
+ *
+ * @param buffer the buffer
+ * @param b whether to mirror the ring
+ *
+ * @return whether the buffer now is (or is not) mirrored.
+ */
+ELTN_API bool ELTN_Buffer_set_mirrored(ELTN_Buffer * buffer, bool b);
+
 /**
  * Whether the buffer has no more bytes to process.
  *
@@ -495,6 +917,8 @@ ELTN_API bool ELTN_Buffer_is_closed(ELTN_Buffer * buffer);
 
 /**
  * Write new text to the buffer.
+ * A synchronized buffer at its maximum capacity writes as much as it can,
+ * then waits for the parser to make room for the rest.
  *
  * @param buffer the buffer
  * @param text string of ASCII or ASCII-like of text
@@ -505,6 +929,57 @@ ELTN_API bool ELTN_Buffer_is_closed(ELTN_Buffer * buffer);
 ELTN_API ssize_t ELTN_Buffer_write(ELTN_Buffer * buffer, const char* text,
                                    size_t len);
 
+/**
+ * Write as much new text as fits without waiting or growing the buffer
+ * past its maximum capacity (see `ELTN_Buffer_set_max_capacity()`).
+ * A return value less than `len` means the buffer is full; the caller
+ * should retry the remainder once the parser has consumed some input.
+ *
+ * @param buffer the buffer
+ * @param text string of ASCII or ASCII-like of text
+ * @param len the number of *bytes* to read from `text`
+ *
+ * @return number of bytes written (0 if the buffer is full),
+ *         or negative if the buffer is closed or on error.
+ */
+ELTN_API ssize_t ELTN_Buffer_write_nb(ELTN_Buffer * buffer, const char* text,
+                                      size_t len);
+
+/**
+ * Write new text to the buffer, waiting at most `timeout_ms` milliseconds
+ * for the parser to make room if the buffer is at its maximum capacity.
+ * Only a synchronized buffer waits; otherwise this acts like
+ * `ELTN_Buffer_write_nb()`.
+ *
+ * @param buffer the buffer
+ * @param text string of ASCII or ASCII-like of text
+ * @param len the number of *bytes* to read from `text`
+ * @param timeout_ms the longest time to wait, in milliseconds
+ *
+ * @return number of bytes written before the timeout (0 if none),
+ *         or negative if the buffer is closed or on error.
+ */
+ELTN_API ssize_t ELTN_Buffer_write_timed(ELTN_Buffer * buffer,
+                                         const char* text, size_t len,
+                                         long timeout_ms);
+
+/**
+ * Read caller-owned text in place, instead of copying it into the buffer.
+ * The text must be the rest of the document, so this closes the buffer
+ * for writing.  The buffer must be empty and have no reader function.
+ *
+ * The caller retains ownership of @p text, and must neither modify nor free
+ * it until the buffer has been read to the end or freed.
+ *
+ * @param buffer the buffer
+ * @param text string of ASCII or ASCII-like of text
+ * @param len the number of *bytes* to read from `text`
+ *
+ * @return number of bytes borrowed, or negative on error.
+ */
+ELTN_API ssize_t ELTN_Buffer_borrow(ELTN_Buffer * buffer, const char* text,
+                                    size_t len);
+
 /**
  * Close the buffer for writing.
  *
@@ -512,6 +987,97 @@ ELTN_API ssize_t ELTN_Buffer_write(ELTN_Buffer * buffer, const char* text,
  */
 ELTN_API void ELTN_Buffer_close(ELTN_Buffer * buffer);
 
+/* ------------------------ Tokenizer -----------------------------*/
+
+/**
+ * Tokens found by {@link ELTN_tokenize}.  Reserved words other than
+ * `true`, `false`, and `nil` are ELTN_TOKEN_INVALID.
+ */
+typedef enum ELTN_Token {
+    ELTN_TOKEN_ERROR = -1,
+    ELTN_TOKEN_INVALID = 0,
+    ELTN_TOKEN_CURLY_OPEN,
+    ELTN_TOKEN_CURLY_CLOSE,
+    ELTN_TOKEN_SQUARE_OPEN,
+    ELTN_TOKEN_SQUARE_CLOSE,
+    ELTN_TOKEN_SEMICOLON,
+    ELTN_TOKEN_COMMA,
+    ELTN_TOKEN_EQUALS,
+    ELTN_TOKEN_NAME,
+    ELTN_TOKEN_STRING,
+    ELTN_TOKEN_LONG_STRING,
+    ELTN_TOKEN_NUMBER,
+    ELTN_TOKEN_INTEGER,
+    ELTN_TOKEN_BOOLEAN_TRUE,
+    ELTN_TOKEN_BOOLEAN_FALSE,
+    ELTN_TOKEN_NIL,
+    ELTN_TOKEN_COMMENT,
+    ELTN_TOKEN_LONG_COMMENT,
+    ELTN_TOKEN_EOF,
+    ELTN_TOKEN_NEED_MORE
+} ELTN_Token;
+
+/**
+ * Provides the symbolic name of every ELTN_Token instance.
+ *
+ * @param token the ELTN_Token code
+ *
+ * @returns the name of the token as a null-terminated string.
+ */
+ELTN_API const char* ELTN_Token_name(ELTN_Token token);
+
+/**
+ * A token found by {@link ELTN_tokenize}: its type, and the bytes of
+ * the text it spans, including any quotes, brackets, and escapes.
+ */
+typedef struct ELTN_Token_Record {
+    ELTN_Token type;
+    uint32_t offset;
+    uint32_t length;
+} ELTN_Token_Record;
+
+/**
+ * Split an in-memory text into tokens, filling up to @p max records
+ * in a single call.  Tokenizing starts at byte `*offsetptr` of @p text
+ * and skips whitespace; it stops after @p max records or a record of
+ * ELTN_TOKEN_EOF, whichever comes first, and sets `*offsetptr` to the end
+ * of the last token recorded, so the caller may call it again with the
+ * same arguments to continue.
+ *
+ * Invalid tokens are recorded as ELTN_TOKEN_INVALID, and tokenizing goes
+ * on after them.  Offsets are from the start of @p text, so @p len may be
+ * at most `UINT32_MAX`.
+ *
+ * @param text string of ASCII or ASCII-like text
+ * @param len the number of *bytes* in `text`
+ * @param offsetptr a pointer to the offset in @p text at which to begin,
+ *                  which receives the offset at which to continue;
+ *                  if NULL, begin at the start.
+ * @param tokens an array to receive the token records
+ * @param max the number of records @p tokens has room for
+ *
+ * @return the number of records filled, or negative if out of memory or
+ *         @p text is too long.
+ */
+ELTN_API ssize_t ELTN_tokenize(const char* text, size_t len,
+                               size_t* offsetptr, ELTN_Token_Record * tokens,
+                               size_t max);
+
+/* ------------------------ Hashing -------------------------------*/
+
+/**
+ * Hash bytes with MurmurHash64A, a fast non-cryptographic hash, reading
+ * the input as little-endian 64-bit words so the result is the same on
+ * every platform.  ELTN_Parser_key_hash() uses this with the parser's seed.
+ *
+ * @param data the bytes to hash
+ * @param len the number of bytes in @p data
+ * @param seed a seed that selects one of a family of hash functions
+ *
+ * @return the 64-bit hash of @p data.
+ */
+ELTN_API uint64_t ELTN_hash(const void* data, size_t len, uint64_t seed);
+
 /* ------------------------ Emitter -------------------------------*/
 
 /**
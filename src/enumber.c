@@ -0,0 +1,299 @@
+/*****************************************************************************
+ *
+ * Copyright 2025 Frank Mitchell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ ****************************************************************************/
+
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "enumber.h"
+#include "estring.h"
+
+/*
+ * Significant digits that always fit in a uint64_t.
+ */
+#define MAX_DECIMAL_DIGITS  19
+#define MAX_HEX_DIGITS      16
+
+/*
+ * Doubles represent every integer up to this, and every power of ten up
+ * to 1e22, exactly.
+ */
+#define MAX_EXACT_MANTISSA  (UINT64_C(1) << 53)
+#define MAX_EXACT_POW10     22
+
+static const double POW10[MAX_EXACT_POW10 + 1] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/*
+ * Keeps absurd exponents from overflowing; anything this big or small
+ * is infinite or zero anyway.
+ */
+#define MAX_EXPONENT 100000
+
+/*
+ * A numeral taken apart: `mantissa` times `base` to the `exponent`,
+ * where base is 10 or 2.  `truncated` if nonzero digits didn't fit.
+ */
+typedef struct Numeral_Parts {
+    uint64_t mantissa;
+    int64_t exponent;
+    bool truncated;
+    bool is_float;
+} Numeral_Parts;
+
+static int digit_value(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+/*
+ * Read an exponent: an optional sign and at least one decimal digit.
+ */
+static const char* read_exponent(const char* p, const char* end,
+                                 int64_t* expptr) {
+    bool negative = false;
+    int64_t exponent = 0;
+
+    if (p < end && (*p == '+' || *p == '-')) {
+        negative = (*p == '-');
+        p++;
+    }
+    if (p == end || !ELTN_CHAR_IS(*p, ELTN_CLASS_DIGIT)) {
+        return NULL;
+    }
+    for (; p < end && ELTN_CHAR_IS(*p, ELTN_CLASS_DIGIT); p++) {
+        if (exponent < MAX_EXPONENT) {
+            exponent = exponent * 10 + (*p - '0');
+        }
+    }
+    (*expptr) = negative ? -exponent : exponent;
+    return p;
+}
+
+/*
+ * Take apart the digits, point, and exponent of a decimal or (if `radix`
+ * is 16) hexadecimal numeral.  Returns false if it isn't one.
+ */
+static bool split_numeral(const char* p, const char* end, int radix,
+                          Numeral_Parts* parts) {
+    const int max_digits =
+        (radix == 16) ? MAX_HEX_DIGITS : MAX_DECIMAL_DIGITS;
+    const int digit_exponent = (radix == 16) ? 4 : 1;
+    const char exp_lower = (radix == 16) ? 'p' : 'e';
+    const char exp_upper = (radix == 16) ? 'P' : 'E';
+    bool any = false;
+    bool fraction = false;
+    int digits = 0;
+    int64_t exponent = 0;
+
+    memset(parts, 0, sizeof(*parts));
+    for (; p < end; p++) {
+        const int d = digit_value(*p);
+
+        if (*p == '.' && !fraction) {
+            fraction = true;
+            parts->is_float = true;
+            continue;
+        }
+        if (d < 0 || d >= radix) {
+            break;
+        }
+        any = true;
+        if (digits < max_digits && (parts->mantissa != 0 || d != 0)) {
+            parts->mantissa = parts->mantissa * radix + d;
+            digits++;
+        } else if (digits >= max_digits) {
+            /*
+             * Out of room: drop the digit, but not its place value.
+             */
+            parts->truncated = parts->truncated || (d != 0);
+            if (!fraction) {
+                parts->exponent += digit_exponent;
+            }
+            continue;
+        }
+        if (fraction) {
+            parts->exponent -= digit_exponent;
+        }
+    }
+    if (!any) {
+        return false;
+    }
+    if (p < end && (*p == exp_lower || *p == exp_upper)) {
+        parts->is_float = true;
+        p = read_exponent(p + 1, end, &exponent);
+        if (p == NULL) {
+            return false;
+        }
+        parts->exponent += exponent;
+    }
+    return p == end;
+}
+
+/*
+ * The slow but always correctly rounded way: let the C library do it.
+ */
+static double convert_slowly(const char* str, size_t len) {
+    char local[128];
+    char* copy = (len < sizeof(local)) ? local : malloc(len + 1);
+    double result;
+
+    if (copy == NULL) {
+        return NAN;
+    }
+    memcpy(copy, str, len);
+    copy[len] = '\0';
+    result = strtod(copy, NULL);
+    if (copy != local) {
+        free(copy);
+    }
+    return fabs(result);
+}
+
+/*
+ * Clinger's fast path: when the mantissa and the power of ten are both
+ * exact doubles, one correctly rounded multiply or divide gives the
+ * correctly rounded result.  Returns false if the numeral doesn't qualify.
+ */
+static bool convert_decimal_quickly(const Numeral_Parts* parts,
+                                    double* numptr) {
+    uint64_t mantissa = parts->mantissa;
+    int64_t exponent = parts->exponent;
+
+    if (parts->truncated || mantissa > MAX_EXACT_MANTISSA) {
+        return false;
+    }
+    if (mantissa == 0) {
+        (*numptr) = 0.0;
+        return true;
+    }
+    /*
+     * Move surplus powers of ten into the mantissa while it stays exact,
+     * e.g. 12e25 = 12000e22.
+     */
+    while (exponent > MAX_EXACT_POW10
+           && mantissa <= MAX_EXACT_MANTISSA / 10) {
+        mantissa *= 10;
+        exponent--;
+    }
+    if (exponent > MAX_EXACT_POW10 || exponent < -MAX_EXACT_POW10) {
+        return false;
+    }
+    if (exponent >= 0) {
+        (*numptr) = (double)mantissa * POW10[exponent];
+    } else {
+        (*numptr) = (double)mantissa / POW10[-exponent];
+    }
+    return true;
+}
+
+/*
+ * Hexadecimal floats are exact as long as the mantissa fits in a double.
+ */
+static bool convert_hex_quickly(const Numeral_Parts* parts, double* numptr) {
+    if (parts->truncated || parts->mantissa > MAX_EXACT_MANTISSA) {
+        return false;
+    }
+    (*numptr) = ldexp((double)parts->mantissa, (int)parts->exponent);
+    return true;
+}
+
+ELTN_Numeral ELTN_parse_numeral(const char* str, size_t len,
+                                int64_t* intptr, double* numptr) {
+    const char* p = str;
+    const char* end = str + len;
+    bool negative = false;
+    int radix = 10;
+    Numeral_Parts parts;
+    double value;
+
+    if (p < end && *p == '-') {
+        negative = true;
+        p++;
+    }
+    if (end - p >= 2 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) {
+        radix = 16;
+        p += 2;
+    }
+    if (!split_numeral(p, end, radix, &parts)) {
+        return ELTN_NUMERAL_INVALID;
+    }
+
+    if (!parts.is_float) {
+        uint64_t magnitude = parts.mantissa;
+        bool fits = (parts.exponent == 0);
+
+        if (radix == 16) {
+            /*
+             * Hexadecimal integers wrap around; so, re-read every digit.
+             */
+            magnitude = 0;
+            for (; p < end; p++) {
+                magnitude = (magnitude << 4) | digit_value(*p);
+            }
+            fits = true;
+        } else if (magnitude > (uint64_t)INT64_MAX + (negative ? 1 : 0)) {
+            fits = false;
+        }
+        if (fits) {
+            const int64_t integer =
+                (int64_t)(negative ? 0 - magnitude : magnitude);
+
+            if (intptr) {
+                (*intptr) = integer;
+            }
+            if (numptr) {
+                (*numptr) = (double)integer;
+            }
+            return ELTN_NUMERAL_INTEGER;
+        }
+    }
+
+    if (radix == 16) {
+        if (!convert_hex_quickly(&parts, &value)) {
+            value = convert_slowly(str, len);
+        }
+    } else if (!convert_decimal_quickly(&parts, &value)) {
+        value = convert_slowly(str, len);
+    }
+    if (isnan(value) || isinf(value)) {
+        return ELTN_NUMERAL_INVALID;
+    }
+    if (numptr) {
+        (*numptr) = negative ? -value : value;
+    }
+    return ELTN_NUMERAL_FLOAT;
+}
@@ -0,0 +1,52 @@
+/*****************************************************************************
+ *
+ * Copyright 2025 Frank Mitchell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ ****************************************************************************/
+
+
+#ifndef __ELTN_NUMBER
+#define __ELTN_NUMBER
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * What a numeral turned out to be.
+ */
+typedef enum ELTN_Numeral {
+    ELTN_NUMERAL_INVALID = 0,
+    ELTN_NUMERAL_INTEGER,
+    ELTN_NUMERAL_FLOAT
+} ELTN_Numeral;
+
+/*
+ * Convert the Lua numeral `str` of `len` bytes, with an optional leading
+ * '-', into an integer in `*intptr` or a float in `*numptr`.
+ *
+ * As in Lua, a decimal integer too big for 64 bits becomes a float, while
+ * a hexadecimal one wraps around.  Floats that overflow are invalid.
+ * Either pointer may be NULL.
+ */
+ELTN_Numeral ELTN_parse_numeral(const char* str, size_t len,
+                                int64_t* intptr, double* numptr);
+
+#endif /* __ELTN_NUMBER */
@@ -27,6 +27,7 @@
 #include <ctype.h>
 #include <wctype.h>
 #include <errno.h>
+#include <limits.h>
 
 #define  ELTN_CORE    1
 #include "eltn.h"
@@ -36,6 +37,7 @@
 #include "ealloc.h"
 #include "estring.h"
 #include "ekeyset.h"
+#include "eintern.h"
 
 #define INIT_BUF_SIZE   512
 
@@ -51,6 +53,17 @@ struct Stack_Frame {
     Stack_Frame* next;
 };
 
+/*
+ * A comment found on the way to the next event, kept until
+ * ELTN_Parser_next() gets to it.
+ */
+typedef struct Comment {
+    char* text;
+    size_t text_len;
+    char* string;
+    size_t string_len;
+} Comment;
+
 struct ELTN_Parser {
     intptr_t _reserved;
     ELTN_Pool* pool;
@@ -61,17 +74,56 @@ struct ELTN_Parser {
      * configuration
      */
     bool include_comments;
+    bool intern_all;
+    uint64_t hash_seed;
+    bool incremental;
+    size_t max_token;
+    unsigned int max_depth;
+    size_t max_document;
 
     /*
      * event state
      */
     ELTN_Event last_event;
     ELTN_Event event;
-    char* text;
+    /*
+     * The current token's text, a view of the lexer's token until
+     * keep_text() copies it, and the event's string value, which is
+     * just the part of the text from `string_offset` for tokens that
+     * need no unquoting.  Other string tokens are only decoded when the
+     * caller asks for the value; until then `string_token` is the kind
+     * of token to decode.
+     */
+    const char* text;
     size_t text_len;
+    char* text_buf;
+    size_t text_max;
     char8_t* string;
     size_t string_len;
     size_t string_max;
+    bool string_is_text;
+    size_t string_offset;
+    ELTN_Token string_token;
+    /*
+     * Keys with IDs, and the ID of the current key, or -1; and the
+     * current key's hash, once something has asked for it.
+     */
+    Intern_Table* interns;
+    int key_id;
+    bool key_hashed;
+    uint64_t key_hash;
+    int64_t integer;
+    double number;
+    /*
+     * Comments found before the current event, delivered first: while
+     * `comment_next` > 0, the event is comments[comment_next - 1] and
+     * `pending_event` waits behind it.
+     */
+    Comment* comments;
+    size_t comment_count;
+    size_t comment_max;
+    size_t comment_next;
+    ELTN_Event pending_event;
     /*
      * Table stack
      */
@@ -84,8 +136,28 @@ struct ELTN_Parser {
     ELTN_Error errcode;
     int errline;
     int errcolumn;
+    bool need_more;             /* input ran dry during this event */
 };
 
+static void clear_comments(ELTN_Parser* self) {
+    for (size_t i = 0; i < self->comment_count; i++) {
+        ELTN_free(self->pool, self->comments[i].text);
+        ELTN_free(self->pool, self->comments[i].string);
+    }
+    self->comment_count = 0;
+    self->comment_next = 0;
+}
+
+/*
+ * The comment being delivered, if the current event is one.
+ */
+static Comment* current_comment(ELTN_Parser* self) {
+    if (self->comment_next == 0) {
+        return NULL;
+    }
+    return &(self->comments[self->comment_next - 1]);
+}
+
 ELTN_API ELTN_Parser* ELTN_Parser_new() {
     return ELTN_Parser_new_with_pool(NULL);
 }
@@ -109,8 +181,10 @@ ELTN_API ELTN_Parser* ELTN_Parser_new_with_pool(ELTN_Pool* pool) {
         ELTN_Parser_free(self);
         return NULL;
     }
-    ELTN_Lexer_set_char_source(self->lexer, ELTN_Buffer_next_char,
+    ELTN_Lexer_set_span_source(self->lexer, ELTN_Buffer_next_span,
                                self->buffer);
+    ELTN_Lexer_set_skip_comments(self->lexer, !self->include_comments);
+    self->key_id = -1;
     return self;
 }
 
@@ -122,11 +196,50 @@ ELTN_API void ELTN_Parser_free(ELTN_Parser* self) {
 
     ELTN_Buffer_free(self->buffer);
     ELTN_Lexer_free(self->lexer);
+    Intern_Table_free(self->interns);
+    clear_comments(self);
+    ELTN_free(h, self->comments);
+    ELTN_free(h, self->text_buf);
     ELTN_free(h, self->string);
     ELTN_free(h, self);
     ELTN_Pool_release(&h);
 }
 
+ELTN_API bool ELTN_Parser_is_incremental(ELTN_Parser* self) {
+    return self->incremental;
+}
+
+ELTN_API void ELTN_Parser_set_incremental(ELTN_Parser* self, bool b) {
+    self->incremental = b;
+    ELTN_Lexer_set_incremental(self->lexer, b);
+}
+
+ELTN_API size_t ELTN_Parser_max_token_length(ELTN_Parser* self) {
+    return self->max_token;
+}
+
+ELTN_API void ELTN_Parser_set_max_token_length(ELTN_Parser* self, size_t len) {
+    self->max_token = len;
+    ELTN_Lexer_set_max_token_length(self->lexer, len);
+}
+
+ELTN_API unsigned int ELTN_Parser_max_depth(ELTN_Parser* self) {
+    return self->max_depth;
+}
+
+ELTN_API void ELTN_Parser_set_max_depth(ELTN_Parser* self, unsigned int depth) {
+    self->max_depth = depth;
+}
+
+ELTN_API size_t ELTN_Parser_max_document_size(ELTN_Parser* self) {
+    return self->max_document;
+}
+
+ELTN_API void ELTN_Parser_set_max_document_size(ELTN_Parser* self, size_t size) {
+    self->max_document = size;
+    ELTN_Lexer_set_max_input(self->lexer, size);
+}
+
 ELTN_API ELTN_Buffer* ELTN_Parser_buffer(ELTN_Parser* self) {
     return self->buffer;
 }
@@ -137,6 +250,51 @@ ELTN_API bool ELTN_Parser_include_comments(ELTN_Parser* self) {
 
 ELTN_API void ELTN_Parser_set_include_comments(ELTN_Parser* self, bool b) {
     self->include_comments = b;
+    ELTN_Lexer_set_skip_comments(self->lexer, !b);
+}
+
+ELTN_API bool ELTN_Parser_intern_keys(ELTN_Parser* self) {
+    return self->intern_all;
+}
+
+ELTN_API void ELTN_Parser_set_intern_keys(ELTN_Parser* self, bool b) {
+    self->intern_all = b;
+}
+
+/*
+ * The table of interned keys, created on first use.
+ */
+static Intern_Table* intern_table(ELTN_Parser* self) {
+    if (self->interns == NULL) {
+        self->interns = Intern_Table_new_with_pool(self->pool);
+        if (self->interns != NULL) {
+            Intern_Table_set_seed(self->interns, self->hash_seed);
+        }
+    }
+    return self->interns;
+}
+
+ELTN_API int ELTN_Parser_intern_key(ELTN_Parser* self, const char* key,
+                                    size_t len) {
+    Intern_Table* interns = intern_table(self);
+
+    if (interns == NULL || (key == NULL && len > 0)) {
+        return -1;
+    }
+    return Intern_Table_add(interns, key, len,
+                            Intern_Table_hash(interns, key, len));
+}
+
+ELTN_API uint64_t ELTN_Parser_hash_seed(ELTN_Parser* self) {
+    return self->hash_seed;
+}
+
+ELTN_API void ELTN_Parser_set_hash_seed(ELTN_Parser* self, uint64_t seed) {
+    self->hash_seed = seed;
+    self->key_hashed = false;
+    if (self->interns != NULL) {
+        Intern_Table_set_seed(self->interns, seed);
+    }
 }
 
 ELTN_API ssize_t ELTN_Parser_read(ELTN_Parser* self, ELTN_Reader reader,
@@ -144,6 +302,11 @@ ELTN_API ssize_t ELTN_Parser_read(ELTN_Parser* self, ELTN_Reader reader,
     return ELTN_Buffer_read(self->buffer, reader, state);
 }
 
+ELTN_API ssize_t ELTN_Parser_read_lent(ELTN_Parser* self, ELTN_Lender lender,
+                                       void* state) {
+    return ELTN_Buffer_read_lent(self->buffer, lender, state);
+}
+
 ELTN_API ssize_t ELTN_Parser_read_string(ELTN_Parser* self, const char* text,
                                          size_t len) {
     ELTN_Buffer* src = ELTN_Parser_buffer(self);
@@ -153,6 +316,12 @@ ELTN_API ssize_t ELTN_Parser_read_string(ELTN_Parser* self, const char* text,
     return result;
 }
 
+ELTN_API ssize_t ELTN_Parser_read_string_in_place(ELTN_Parser* self,
+                                                  const char* text,
+                                                  size_t len) {
+    return ELTN_Buffer_borrow(ELTN_Parser_buffer(self), text, len);
+}
+
 ELTN_API bool ELTN_Parser_has_next(ELTN_Parser* self) {
     ELTN_Event ev = ELTN_Parser_event(self);
 
@@ -163,6 +332,48 @@ ELTN_API ELTN_Event ELTN_Parser_event(ELTN_Parser* self) {
     return self->event;
 }
 
+ELTN_API int ELTN_Parser_key_id(ELTN_Parser* self) {
+    if (current_comment(self) != NULL) {
+        return -1;
+    }
+    return self->key_id;
+}
+
+static void hash_key(ELTN_Parser* self, const char* str, size_t len) {
+    self->key_hash = ELTN_hash(str, len, self->hash_seed);
+    self->key_hashed = true;
+}
+
+ELTN_API uint64_t ELTN_Parser_key_hash(ELTN_Parser* self) {
+    const char* str;
+    size_t len;
+
+    if (current_comment(self) != NULL
+        || (self->event != ELTN_DEF_NAME && self->event != ELTN_KEY_STRING)) {
+        return 0;
+    }
+    if (!self->key_hashed) {
+        ELTN_Parser_string_view(self, &str, &len);
+        if (str == NULL) {
+            return 0;
+        }
+        hash_key(self, str, len);
+    }
+    return self->key_hash;
+}
+
+ELTN_API void ELTN_Parser_interned_key(ELTN_Parser* self, int id,
+                                       const char** strptr, size_t* lenptr) {
+    if (strptr == NULL || lenptr == NULL) {
+        return;
+    }
+    (*strptr) = NULL;
+    (*lenptr) = 0;
+    if (self->interns != NULL) {
+        (*strptr) = Intern_Table_string(self->interns, id, lenptr);
+    }
+}
+
 ELTN_API unsigned int ELTN_Parser_depth(ELTN_Parser* self) {
     /*
      * TODO: take from depth of context stack
@@ -177,33 +388,116 @@ ELTN_API void ELTN_Parser_current_key(ELTN_Parser* self, ELTN_Event* typeptr,
      */
 }
 
+ELTN_API void ELTN_Parser_text_view(ELTN_Parser* self, const char** strptr,
+                                    size_t* sizeptr) {
+    Comment* comment = current_comment(self);
+
+    if (strptr == NULL || sizeptr == NULL) {
+        return;
+    }
+
+    if (comment != NULL) {
+        (*strptr) = comment->text;
+        (*sizeptr) = comment->text_len;
+    } else if (self->text == NULL) {
+        (*strptr) = "";
+        (*sizeptr) = 0;
+    } else {
+        (*strptr) = self->text;
+        (*sizeptr) = self->text_len;
+    }
+}
+
 ELTN_API void ELTN_Parser_text(ELTN_Parser* self, char** strptr,
                                size_t* sizeptr) {
+    const char* text;
+    size_t len;
+
     if (strptr == NULL || sizeptr == NULL) {
         return;
     }
 
-    if (self->text == NULL) {
-        ELTN_new_string(strptr, sizeptr, "", 0);
+    ELTN_Parser_text_view(self, &text, &len);
+    ELTN_new_string(strptr, sizeptr, text, len);
+}
+
+static bool decode_string(ELTN_Parser* self);
+
+ELTN_API void ELTN_Parser_string_view(ELTN_Parser* self, const char** strptr,
+                                      size_t* sizeptr) {
+    Comment* comment = current_comment(self);
+
+    if (strptr == NULL || sizeptr == NULL) {
         return;
     }
 
-    ELTN_new_string(strptr, sizeptr, (const char *)self->text, self->text_len);
+    if (comment != NULL) {
+        (*strptr) = comment->string;
+        (*sizeptr) = comment->string_len;
+    } else if (self->key_id >= 0) {
+        (*strptr) = Intern_Table_string(self->interns, self->key_id, sizeptr);
+    } else if (!decode_string(self)) {
+        (*strptr) = NULL;
+        (*sizeptr) = 0;
+    } else if (self->string_is_text && self->text != NULL) {
+        (*strptr) = self->text + self->string_offset;
+        (*sizeptr) = self->string_len;
+    } else if (self->string_is_text || self->string == NULL) {
+        (*strptr) = "";
+        (*sizeptr) = 0;
+    } else {
+        (*strptr) = (const char *)self->string;
+        (*sizeptr) = self->string_len;
+    }
 }
 
 ELTN_API void ELTN_Parser_string(ELTN_Parser* self, char** strptr,
                                  size_t* sizeptr) {
+    const char* str;
+    size_t len;
+
     if (strptr == NULL || sizeptr == NULL) {
         return;
     }
 
-    if (self->string == NULL) {
-        ELTN_new_string(strptr, sizeptr, "", 0);
+    ELTN_Parser_string_view(self, &str, &len);
+    if (str == NULL) {
+        (*strptr) = NULL;
+        (*sizeptr) = 0;
         return;
     }
+    ELTN_new_string(strptr, sizeptr, str, len);
+}
+
+/*
+ * Copy as much of `str` as fits into `buf`, and a NUL if there's room.
+ */
+static size_t copy_into(const char* str, size_t len, char* buf, size_t cap) {
+    if (buf != NULL && cap > 0 && str != NULL) {
+        memcpy(buf, str, (len < cap) ? len : cap);
+        if (len < cap) {
+            buf[len] = '\0';
+        }
+    }
+    return len;
+}
+
+ELTN_API size_t ELTN_Parser_text_copy_into(ELTN_Parser* self, char* buf,
+                                           size_t cap) {
+    const char* text;
+    size_t len;
+
+    ELTN_Parser_text_view(self, &text, &len);
+    return copy_into(text, len, buf, cap);
+}
+
+ELTN_API size_t ELTN_Parser_string_copy_into(ELTN_Parser* self, char* buf,
+                                             size_t cap) {
+    const char* str;
+    size_t len;
 
-    ELTN_new_string(strptr, sizeptr, (const char *)self->string,
-                    self->string_len);
+    ELTN_Parser_string_view(self, &str, &len);
+    return copy_into(str, len, buf, cap);
 }
 
 ELTN_API double ELTN_Parser_number(ELTN_Parser* self) {
@@ -214,7 +508,7 @@ ELTN_API double ELTN_Parser_number(ELTN_Parser* self) {
     case ELTN_KEY_INTEGER:
     case ELTN_VALUE_NUMBER:
     case ELTN_VALUE_INTEGER:
-        return strtod((const char *)self->string, NULL);
+        return self->number;
     default:
         return 0.0;
     }
@@ -222,19 +516,22 @@ ELTN_API double ELTN_Parser_number(ELTN_Parser* self) {
 
 ELTN_API long int ELTN_Parser_integer(ELTN_Parser* self) {
     ELTN_Event ev = ELTN_Parser_event(self);
-    int base = 10;
 
     switch (ev) {
-    case ELTN_KEY_NUMBER:
     case ELTN_KEY_INTEGER:
-    case ELTN_VALUE_NUMBER:
     case ELTN_VALUE_INTEGER:
-        if (strncasecmp((const char *)self->string, "0x", 2) == 0) {
-            base = 16;
+        return self->integer;
+    case ELTN_KEY_NUMBER:
+    case ELTN_VALUE_NUMBER:
+        /*
+         * Truncate, if it fits.
+         */
+        if (self->number > -LONG_MAX && self->number < LONG_MAX) {
+            return (long int)self->number;
         }
-        return strtol((const char *)self->string, NULL, base);
+        return 0;
     default:
-        return 0.0;
+        return 0;
     }
 }
 
@@ -275,91 +572,166 @@ static void set_string_ref(ELTN_Parser* self, char* str, size_t len) {
         self->string = (char8_t *) str;
         self->string_len = len;
         self->string_max = len;
+        self->string_is_text = false;
         return;
     }
 }
 
-static bool set_string_copy(ELTN_Parser* self, char* str, size_t len) {
-    if (self->string == NULL || self->string_max <= len) {
-        self->string = ELTN_realloc(self->pool, self->string, len + 1);
-        if (self->string == NULL) {
-            signal_out_of_memory(self);
-            return false;
-        }
-        self->string_len = len;
-        self->string_max = len + 1;
+static void capture_token(ELTN_Parser* self) {
+    ELTN_Lexer_token_view(self->lexer, &(self->text), &(self->text_len));
+    self->string_is_text = true;
+    self->string_offset = 0;
+    self->string_len = self->text_len;
+    self->string_token = ELTN_TOKEN_INVALID;
+    self->key_id = -1;
+    self->key_hashed = false;
+}
+
+static void forget_token(ELTN_Parser* self) {
+    self->text = NULL;
+    self->text_len = 0;
+    self->string_is_text = true;
+    self->string_offset = 0;
+    self->string_len = 0;
+    self->string_token = ELTN_TOKEN_INVALID;
+    self->key_id = -1;
+    self->key_hashed = false;
+}
+
+/*
+ * Decode the value of the current string token, if that hasn't been
+ * done yet.  Returns false if out of memory.
+ */
+static bool decode_string(ELTN_Parser* self) {
+    char* str = NULL;
+    size_t len = 0;
+
+    switch (self->string_token) {
+    case ELTN_TOKEN_STRING:
+        ELTN_unescape_quoted_string(self->pool, self->text, self->text_len,
+                                    &str, &len);
+        break;
+    case ELTN_TOKEN_LONG_STRING:
+        ELTN_unquote_long_string(self->pool, self->text, self->text_len, &str,
+                                 &len);
+        break;
+    default:
+        return true;
     }
-    memset(self->string, 0, self->string_max);
     if (str == NULL) {
-        self->string_len = 0;
-    } else {
-        memcpy(self->string, str, len);
-        self->string_len = len;
+        return false;
     }
+    set_string_ref(self, str, len);
+    self->string_token = ELTN_TOKEN_INVALID;
     return true;
 }
 
-static void capture_token_buffer(ELTN_Parser* self) {
-    char* tokstr = NULL;
-    size_t toklen = 0;
+/*
+ * Copy the token text out of the lexer, before it moves on to the next
+ * token, and return it as a C string.
+ */
+static const char* keep_text(ELTN_Parser* self) {
+    if (self->text != NULL && self->text == self->text_buf) {
+        return self->text_buf;
+    }
+    if (self->text_buf == NULL || self->text_max <= self->text_len) {
+        char* tmp = ELTN_realloc(self->pool, self->text_buf,
+                                 self->text_len + 1);
+
+        if (tmp == NULL) {
+            signal_out_of_memory(self);
+            forget_token(self);
+            return "";
+        }
+        self->text_buf = tmp;
+        self->text_max = self->text_len + 1;
+    }
+    if (self->text_len > 0) {
+        memcpy(self->text_buf, self->text, self->text_len);
+    }
+    self->text_buf[self->text_len] = '\0';
+    self->text = self->text_buf;
+    return self->text_buf;
+}
+
+/*
+ * Look up the ID of the current key, giving it one if the parser interns
+ * every key.
+ */
+static void intern_key(ELTN_Parser* self) {
+    const char* str;
+    size_t len;
 
-    ELTN_Lexer_token_string(self->lexer, &tokstr, &toklen);
-    ELTN_free_string(self->text);
-    self->text = tokstr;
-    self->text_len = toklen;
+    if (self->interns == NULL && !self->intern_all) {
+        return;
+    }
+    ELTN_Parser_string_view(self, &str, &len);
+    if (str == NULL) {
+        signal_out_of_memory(self);
+        return;
+    }
+    hash_key(self, str, len);
+    if (!self->intern_all) {
+        self->key_id = Intern_Table_find(self->interns, str, len,
+                                         self->key_hash);
+        return;
+    }
+    if (intern_table(self) == NULL) {
+        signal_out_of_memory(self);
+        return;
+    }
+    self->key_id = Intern_Table_add(self->interns, str, len, self->key_hash);
+    if (self->key_id < 0) {
+        signal_out_of_memory(self);
+    }
 }
 
 static void set_event(ELTN_Parser* self, ELTN_Token token, ELTN_Event event) {
-    char* str = NULL;
+    const char* body = NULL;
     size_t len = 0;
 
     self->event = event;
-    capture_token_buffer(self);
+    capture_token(self);
     switch (token) {
     case ELTN_TOKEN_STRING:
-        ELTN_unescape_quoted_string(self->pool, self->text, self->text_len,
-                                    &str, &len);
-        if (str == NULL) {
-            signal_out_of_memory(self);
-            return;
+        if (ELTN_quoted_string_body(self->text, self->text_len, &body,
+                                    &len)) {
+            /*
+             * Without escapes, the value is the text between the quotes.
+             */
+            self->string_offset = body - self->text;
+            self->string_len = len;
+            break;
         }
-        set_string_ref(self, str, len);
+        self->string_token = token;
         break;
     case ELTN_TOKEN_LONG_STRING:
-        ELTN_unquote_long_string(self->pool, self->text, self->text_len, &str,
-                                 &len);
-        if (str == NULL) {
-            signal_out_of_memory(self);
-            return;
-        }
-        set_string_ref(self, str, len);
+        self->string_token = token;
         break;
-    case ELTN_TOKEN_COMMENT:
-    case ELTN_TOKEN_LONG_COMMENT:
-        ELTN_trim_comment(self->pool, self->text, self->text_len, &str, &len);
-        if (str == NULL) {
-            signal_out_of_memory(self);
-            return;
-        }
-        set_string_ref(self, str, len);
+    case ELTN_TOKEN_INTEGER:
+    case ELTN_TOKEN_NUMBER:
+        self->integer = ELTN_Lexer_integer(self->lexer);
+        self->number = ELTN_Lexer_number(self->lexer);
         break;
     default:
-        if (!set_string_copy(self, self->text, self->text_len)) {
-            signal_out_of_memory(self);
-            return;
-        }
         break;
     }
+    if (event == ELTN_DEF_NAME || event == ELTN_KEY_STRING) {
+        intern_key(self);
+    }
 }
 
-static void signal_error(ELTN_Parser* self, ELTN_Token token,
-                         int line, int column) {
+static void signal_error(ELTN_Parser* self, ELTN_Token token) {
     self->event = ELTN_ERROR;
-    capture_token_buffer(self);
-    set_string_copy(self, self->text, self->text_len);
-    self->errline = line;
-    self->errcolumn = column;
-    if (token == ELTN_TOKEN_INVALID) {
+    capture_token(self);
+    ELTN_Lexer_token_position(self->lexer, &self->errline, &self->errcolumn);
+    if ((token == ELTN_TOKEN_ERROR || token == ELTN_TOKEN_EOF)
+        && ELTN_Lexer_error(self->lexer) != ELTN_OK) {
+        self->errcode = ELTN_Lexer_error(self->lexer);
+    } else if ((token == ELTN_TOKEN_ERROR || token == ELTN_TOKEN_EOF)
+               && ELTN_Buffer_error(self->buffer) != ELTN_OK) {
+        self->errcode = ELTN_Buffer_error(self->buffer);
+    } else if (token == ELTN_TOKEN_INVALID) {
         self->errcode = ELTN_ERR_INVALID_TOKEN;
     } else if (token == ELTN_TOKEN_EOF) {
         self->errcode = ELTN_ERR_STREAM_END;
@@ -373,20 +745,69 @@ static void signal_error(ELTN_Parser* self, ELTN_Token token,
     }
 }
 
-static ELTN_Token next_token(ELTN_Parser* self, int* lineptr, int* columnptr) {
-    ELTN_Token nextToken =
-        ELTN_Lexer_next_token(self->lexer, lineptr, columnptr);
+static void signal_limit_exceeded(ELTN_Parser* self, ELTN_Token token) {
+    signal_error(self, token);
+    self->errcode = ELTN_ERR_LIMIT_EXCEEDED;
+}
+
+static bool start_table(ELTN_Parser* self, ELTN_Token token) {
+    if (self->max_depth > 0 && self->depth >= self->max_depth) {
+        signal_limit_exceeded(self, token);
+        return true;
+    }
+    set_event(self, token, ELTN_TABLE_START);
+    // TODO: Push a new frame on the stack
+    self->depth++;
+    return true;
+}
+
+/*
+ * Copy the current comment token to the end of the comment queue.
+ */
+static void enqueue_comment(ELTN_Parser* self) {
+    const char* text;
+    size_t len;
+    Comment* comment;
+
+    if (self->comment_count >= self->comment_max) {
+        size_t max = (self->comment_max == 0) ? 4 : 2 * self->comment_max;
+        Comment* tmp = ELTN_realloc(self->pool, self->comments,
+                                    max * sizeof(Comment));
+
+        if (tmp == NULL) {
+            signal_out_of_memory(self);
+            return;
+        }
+        self->comments = tmp;
+        self->comment_max = max;
+    }
+    ELTN_Lexer_token_view(self->lexer, &text, &len);
+    comment = &(self->comments[self->comment_count]);
+    ELTN_new_string_in_pool(self->pool, &(comment->text), &(comment->text_len),
+                            text, len);
+    ELTN_trim_comment(self->pool, text, len, &(comment->string),
+                      &(comment->string_len));
+    if (comment->text == NULL || comment->string == NULL) {
+        ELTN_free(self->pool, comment->text);
+        ELTN_free(self->pool, comment->string);
+        signal_out_of_memory(self);
+        return;
+    }
+    self->comment_count++;
+}
+
+static ELTN_Token next_token(ELTN_Parser* self) {
+    ELTN_Token nextToken = ELTN_Lexer_next_token(self->lexer, NULL, NULL);
+
     while (nextToken == ELTN_TOKEN_COMMENT ||
            nextToken == ELTN_TOKEN_LONG_COMMENT) {
-        /*
-         * TODO: Something like this:
-         *
-         * if (ELTN_Parser_include_comments(self)) {
-         *     enqueue_event(self, ELTN_COMMENT, token, lineptr, columnptr);
-         *     continue;
-         * }
-         */
-        nextToken = ELTN_Lexer_next_token(self->lexer, lineptr, columnptr);
+        if (self->include_comments) {
+            enqueue_comment(self);
+        }
+        nextToken = ELTN_Lexer_next_token(self->lexer, NULL, NULL);
+    }
+    if (nextToken == ELTN_TOKEN_NEED_MORE) {
+        self->need_more = true;
     }
     return nextToken;
 }
@@ -415,25 +836,21 @@ static bool expect_value(ELTN_Parser* self, ELTN_Token token) {
         set_event(self, token, ELTN_VALUE_NIL);
         return true;
     case ELTN_TOKEN_CURLY_OPEN:
-        set_event(self, token, ELTN_TABLE_START);
-        // TODO: Push a new frame on the stack
-        self->depth++;
-        return true;
+        return start_table(self, token);
     default:
         return false;
     }
     return false;
 }
 
-static bool expect_new_entry(ELTN_Parser* self, ELTN_Token token, int* lineptr,
-                             int* colptr) {
+static bool expect_new_entry(ELTN_Parser* self, ELTN_Token token) {
     if (token == ELTN_TOKEN_NAME) {
         set_event(self, token, ELTN_KEY_STRING);
         return true;
     }
     if (token == ELTN_TOKEN_SQUARE_OPEN) {
         // a non-identifier key
-        token = next_token(self, lineptr, colptr);
+        token = next_token(self);
         switch (token) {
         case ELTN_TOKEN_STRING:
             set_event(self, token, ELTN_KEY_STRING);
@@ -453,10 +870,11 @@ static bool expect_new_entry(ELTN_Parser* self, ELTN_Token token, int* lineptr,
         /*
          * TODO: update current_key on the current stack frame.
          */
+        keep_text(self);
 
-        token = next_token(self, lineptr, colptr);
+        token = next_token(self);
         if (token != ELTN_TOKEN_SQUARE_CLOSE) {
-            signal_error(self, token, *lineptr, *colptr);
+            signal_error(self, token);
         }
         return true;
     }
@@ -473,10 +891,7 @@ static bool expect_new_entry(ELTN_Parser* self, ELTN_Token token, int* lineptr,
 
 static bool expect_table_start(ELTN_Parser* self, ELTN_Token token) {
     if (token == ELTN_TOKEN_CURLY_OPEN) {
-        set_event(self, token, ELTN_TABLE_START);
-        // TODO: Push a new frame on the stack
-        self->depth++;
-        return true;
+        return start_table(self, token);
     }
     return false;
 }
@@ -491,10 +906,9 @@ static bool expect_table_end(ELTN_Parser* self, ELTN_Token token) {
     return false;
 }
 
-static bool expect_new_definition(ELTN_Parser* self, ELTN_Token token,
-                                  int* lineptr, int* colptr) {
+static bool expect_new_definition(ELTN_Parser* self, ELTN_Token token) {
     while (token == ELTN_TOKEN_SEMICOLON) {
-        token = next_token(self, lineptr, colptr);
+        token = next_token(self);
     }
     if (token == ELTN_TOKEN_NAME) {
         set_event(self, token, ELTN_DEF_NAME);
@@ -508,22 +922,25 @@ static bool expect_new_definition(ELTN_Parser* self, ELTN_Token token,
 }
 
 static bool expect_stream_end(ELTN_Parser* self, ELTN_Token token) {
-    if (token == ELTN_TOKEN_EOF) {
+    /*
+     * If the buffer or lexer stopped early, the document isn't over.
+     */
+    if (token == ELTN_TOKEN_EOF && ELTN_Lexer_error(self->lexer) == ELTN_OK
+        && ELTN_Buffer_error(self->buffer) == ELTN_OK) {
         set_event(self, token, ELTN_STREAM_END);
         return true;
     }
     return false;
 }
 
-ELTN_API void ELTN_Parser_next(ELTN_Parser* self) {
+static void next_event(ELTN_Parser* self) {
     ELTN_Token token;
-    int line, column;
 
-    if (self->event != ELTN_COMMENT) {
+    if (self->event != ELTN_NEED_MORE_INPUT) {
         self->last_event = self->event;
     }
 
-    token = next_token(self, &line, &column);
+    token = next_token(self);
 
     switch (self->last_event) {
     case ELTN_STREAM_START:
@@ -531,32 +948,28 @@ ELTN_API void ELTN_Parser_next(ELTN_Parser* self) {
         if (expect_table_start(self, token)) {
             self->no_defs = true;
             return;
-        } else if (expect_new_definition(self, token, &line, &column)) {
+        } else if (expect_new_definition(self, token)) {
             return;
         } else if (expect_stream_end(self, token)) {
             return;
         } else {
-            signal_error(self, token, line, column);
+            signal_error(self, token);
         }
         break;
-    case ELTN_COMMENT:
-        // check what the previous (non-comment) event was ...
-        ELTN_Parser_next(self);
-        break;
     case ELTN_DEF_NAME:
     case ELTN_KEY_STRING:
     case ELTN_KEY_NUMBER:
     case ELTN_KEY_INTEGER:
         // expect a value for this key or a table start
         if (token != ELTN_TOKEN_EQUALS) {
-            signal_error(self, token, line, column);
+            signal_error(self, token);
             return;
         }
-        token = next_token(self, &line, &column);
+        token = next_token(self);
         if (expect_value(self, token)) {
             return;
         } else {
-            signal_error(self, token, line, column);
+            signal_error(self, token);
         }
         break;
     case ELTN_TABLE_END:
@@ -568,45 +981,100 @@ ELTN_API void ELTN_Parser_next(ELTN_Parser* self) {
     case ELTN_VALUE_NIL:
         if (self->depth == 0) {
             if (!self->no_defs
-                && expect_new_definition(self, token, &line, &column)) {
+                && expect_new_definition(self, token)) {
                 return;
             } else if (expect_stream_end(self, token)) {
                 return;
             } else {
-                signal_error(self, token, line, column);
+                signal_error(self, token);
             }
         } else if (token == ELTN_TOKEN_COMMA || token == ELTN_TOKEN_SEMICOLON) {
             // bypass the (required) separator, unless this is the top level
             // TODO: only semicolons or nothing at the definition level
-            token = next_token(self, &line, &column);
-            if (expect_new_entry(self, token, &line, &column)) {
+            token = next_token(self);
+            if (expect_new_entry(self, token)) {
                 return;
             } else if (expect_table_end(self, token)) {
                 return;
             } else {
-                signal_error(self, token, line, column);
+                signal_error(self, token);
             }
         } else {
             if (expect_table_end(self, token)) {
                 return;
             } else {
-                signal_error(self, token, line, column);
+                signal_error(self, token);
             }
         }
         break;
     case ELTN_TABLE_START:
         // expect new keys or values, or a table end
-        if (expect_new_entry(self, token, &line, &column)) {
+        if (expect_new_entry(self, token)) {
             return;
         } else if (expect_table_end(self, token)) {
             return;
         } else {
-            signal_error(self, token, line, column);
+            signal_error(self, token);
         }
         break;
     case ELTN_STREAM_END:
     case ELTN_ERROR:
-        // expect nothing: we're at an end state
+    case ELTN_NEED_MORE_INPUT:
+    case ELTN_COMMENT:
+        // expect nothing: we're at an end state, or (comments) never here
         break;
     }
 }
+
+ELTN_API void ELTN_Parser_next(ELTN_Parser* self) {
+    /*
+     * Synchronized buffers wait for input rather than run dry, and
+     * holding a whole event in one could fill it before the writer is
+     * done; lent buffers end when the lender does.
+     */
+    const bool resumable = self->incremental
+        && !ELTN_Buffer_is_lent(self->buffer)
+        && !ELTN_Buffer_is_synchronized(self->buffer);
+
+    if (self->comment_next > 0) {
+        /*
+         * Deliver the rest of the comments, then the event behind them.
+         */
+        if (self->comment_next < self->comment_count) {
+            self->comment_next++;
+            return;
+        }
+        clear_comments(self);
+        self->event = self->pending_event;
+        return;
+    }
+    if (self->event == ELTN_STREAM_END || self->event == ELTN_ERROR) {
+        return;
+    }
+    if (resumable) {
+        ELTN_Lexer_mark(self->lexer);
+    }
+    self->need_more = false;
+
+    next_event(self);
+
+    if (resumable && self->need_more) {
+        /*
+         * Back up to where this event started, to try again later.
+         */
+        ELTN_Lexer_rewind(self->lexer);
+        forget_token(self);
+        clear_comments(self);
+        self->event = ELTN_NEED_MORE_INPUT;
+        self->errcode = ELTN_OK;
+        self->errline = 0;
+        self->errcolumn = 0;
+    } else if (resumable) {
+        ELTN_Lexer_unmark(self->lexer);
+    }
+    if (self->comment_count > 0) {
+        self->pending_event = self->event;
+        self->event = ELTN_COMMENT;
+        self->comment_next = 1;
+    }
+}
@@ -0,0 +1,355 @@
+/*****************************************************************************
+ *
+ * Copyright 2025 Frank Mitchell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ ****************************************************************************/
+
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "escan.h"
+#include "estring.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__) \
+    && defined(__GNUC__) && !defined(__TINYC__)
+#define ELTN_SCAN_X86   1
+#include <immintrin.h>
+#endif
+
+typedef const char8_t* (*Scan_Fcn)(const char8_t* ptr, const char8_t* end);
+
+typedef size_t(*Count_Fcn) (const char8_t* ptr, const char8_t* end,
+                            const char8_t** afterptr);
+
+/*
+ * The scanners for one instruction set.
+ */
+typedef struct Scanners {
+    ELTN_Scan_Level level;
+    Scan_Fcn string_stop;
+    Scan_Fcn non_blank;
+    Count_Fcn count_lines;
+} Scanners;
+
+/* ---------------------------- Scalar Fallback ---------------------------- */
+
+static const char8_t* string_stop_scalar(const char8_t* ptr,
+                                         const char8_t* end) {
+    while (ptr < end && !ELTN_CHAR_IS(*ptr, ELTN_CLASS_STRING_STOP)) {
+        ptr++;
+    }
+    return ptr;
+}
+
+static const char8_t* non_blank_scalar(const char8_t* ptr,
+                                       const char8_t* end) {
+    while (ptr < end && ELTN_CHAR_IS(*ptr, ELTN_CLASS_BLANK)) {
+        ptr++;
+    }
+    return ptr;
+}
+
+static size_t count_lines_scalar(const char8_t* ptr, const char8_t* end,
+                                 const char8_t** afterptr) {
+    size_t count = 0;
+
+    for (; ptr < end; ptr++) {
+        if (*ptr == '\n') {
+            count++;
+            (*afterptr) = ptr + 1;
+        }
+    }
+    return count;
+}
+
+static const Scanners SCALAR_SCANNERS = {
+    .level = ELTN_SCAN_SCALAR,
+    .string_stop = string_stop_scalar,
+    .non_blank = non_blank_scalar,
+    .count_lines = count_lines_scalar
+};
+
+#ifdef ELTN_SCAN_X86
+
+/* --------------------------------- SSE2 --------------------------------- */
+
+static inline __m128i string_stop_mask_sse2(__m128i v) {
+    __m128i hit = _mm_cmpeq_epi8(v, _mm_set1_epi8('\''));
+
+    hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, _mm_set1_epi8('"')));
+    hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, _mm_set1_epi8('\\')));
+    hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, _mm_set1_epi8('\r')));
+    hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, _mm_set1_epi8('\n')));
+    return hit;
+}
+
+static const char8_t* string_stop_sse2(const char8_t* ptr,
+                                       const char8_t* end) {
+    while (end - ptr >= 16) {
+        const __m128i v = _mm_loadu_si128((const __m128i *)ptr);
+        const int bits = _mm_movemask_epi8(string_stop_mask_sse2(v));
+
+        if (bits != 0) {
+            return ptr + __builtin_ctz(bits);
+        }
+        ptr += 16;
+    }
+    return string_stop_scalar(ptr, end);
+}
+
+/*
+ * Blanks are ' ' and '\t' through '\r' except '\n'.
+ */
+static inline __m128i blank_mask_sse2(__m128i v) {
+    const __m128i off = _mm_sub_epi8(v, _mm_set1_epi8('\t'));
+    const __m128i ctrl = _mm_cmpeq_epi8(_mm_min_epu8(off, _mm_set1_epi8(4)),
+                                        off);
+    const __m128i nl = _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'));
+    const __m128i sp = _mm_cmpeq_epi8(v, _mm_set1_epi8(' '));
+
+    return _mm_or_si128(_mm_andnot_si128(nl, ctrl), sp);
+}
+
+static const char8_t* non_blank_sse2(const char8_t* ptr, const char8_t* end) {
+    while (end - ptr >= 16) {
+        const __m128i v = _mm_loadu_si128((const __m128i *)ptr);
+        const int bits = ~_mm_movemask_epi8(blank_mask_sse2(v)) & 0xFFFF;
+
+        if (bits != 0) {
+            return ptr + __builtin_ctz(bits);
+        }
+        ptr += 16;
+    }
+    return non_blank_scalar(ptr, end);
+}
+
+static size_t count_lines_sse2(const char8_t* ptr, const char8_t* end,
+                               const char8_t** afterptr) {
+    const __m128i nl = _mm_set1_epi8('\n');
+    size_t count = 0;
+
+    while (end - ptr >= 16) {
+        const __m128i v = _mm_loadu_si128((const __m128i *)ptr);
+        const unsigned int bits =
+            (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(v, nl));
+
+        if (bits != 0) {
+            count += __builtin_popcount(bits);
+            (*afterptr) = ptr + 32 - __builtin_clz(bits);
+        }
+        ptr += 16;
+    }
+    return count + count_lines_scalar(ptr, end, afterptr);
+}
+
+static const Scanners SSE2_SCANNERS = {
+    .level = ELTN_SCAN_SSE2,
+    .string_stop = string_stop_sse2,
+    .non_blank = non_blank_sse2,
+    .count_lines = count_lines_sse2
+};
+
+/* --------------------------------- AVX2 --------------------------------- */
+
+#define AVX2 __attribute__((target("avx2")))
+
+AVX2 static inline __m256i string_stop_mask_avx2(__m256i v) {
+    __m256i hit = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\''));
+
+    hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')));
+    hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\')));
+    hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')));
+    hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')));
+    return hit;
+}
+
+AVX2 static const char8_t* string_stop_avx2(const char8_t* ptr,
+                                            const char8_t* end) {
+    while (end - ptr >= 32) {
+        const __m256i v = _mm256_loadu_si256((const __m256i *)ptr);
+        const uint32_t bits =
+            (uint32_t)_mm256_movemask_epi8(string_stop_mask_avx2(v));
+
+        if (bits != 0) {
+            return ptr + __builtin_ctz(bits);
+        }
+        ptr += 32;
+    }
+    return string_stop_sse2(ptr, end);
+}
+
+AVX2 static inline __m256i blank_mask_avx2(__m256i v) {
+    const __m256i off = _mm256_sub_epi8(v, _mm256_set1_epi8('\t'));
+    const __m256i ctrl =
+        _mm256_cmpeq_epi8(_mm256_min_epu8(off, _mm256_set1_epi8(4)), off);
+    const __m256i nl = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'));
+    const __m256i sp = _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' '));
+
+    return _mm256_or_si256(_mm256_andnot_si256(nl, ctrl), sp);
+}
+
+AVX2 static const char8_t* non_blank_avx2(const char8_t* ptr,
+                                          const char8_t* end) {
+    while (end - ptr >= 32) {
+        const __m256i v = _mm256_loadu_si256((const __m256i *)ptr);
+        const uint32_t bits =
+            ~(uint32_t)_mm256_movemask_epi8(blank_mask_avx2(v));
+
+        if (bits != 0) {
+            return ptr + __builtin_ctz(bits);
+        }
+        ptr += 32;
+    }
+    return non_blank_sse2(ptr, end);
+}
+
+AVX2 static size_t count_lines_avx2(const char8_t* ptr, const char8_t* end,
+                                    const char8_t** afterptr) {
+    const __m256i nl = _mm256_set1_epi8('\n');
+    size_t count = 0;
+
+    while (end - ptr >= 32) {
+        const __m256i v = _mm256_loadu_si256((const __m256i *)ptr);
+        const uint32_t bits =
+            (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, nl));
+
+        if (bits != 0) {
+            count += __builtin_popcount(bits);
+            (*afterptr) = ptr + 32 - __builtin_clz(bits);
+        }
+        ptr += 32;
+    }
+    return count + count_lines_sse2(ptr, end, afterptr);
+}
+
+#undef AVX2
+
+static const Scanners AVX2_SCANNERS = {
+    .level = ELTN_SCAN_AVX2,
+    .string_stop = string_stop_avx2,
+    .non_blank = non_blank_avx2,
+    .count_lines = count_lines_avx2
+};
+
+#endif /* ELTN_SCAN_X86 */
+
+/* ------------------------------- Dispatch ------------------------------- */
+
+/*
+ * The scanners in use, which know their own level, so the two can't get
+ * out of step; NULL until the first scan or ELTN_scan_set_level().
+ */
+static _Atomic(const Scanners *) current = NULL;
+
+static bool level_supported(ELTN_Scan_Level level) {
+    switch (level) {
+    case ELTN_SCAN_SCALAR:
+        return true;
+#ifdef ELTN_SCAN_X86
+    case ELTN_SCAN_SSE2:
+        return true;
+    case ELTN_SCAN_AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return false;
+    }
+}
+
+/*
+ * The scanners for `level` or, if the CPU doesn't support it, the widest
+ * level below it that it does.
+ */
+static const Scanners* scanners_for(ELTN_Scan_Level level) {
+    while (level > ELTN_SCAN_SCALAR && !level_supported(level)) {
+        level--;
+    }
+    switch (level) {
+#ifdef ELTN_SCAN_X86
+    case ELTN_SCAN_AVX2:
+        return &AVX2_SCANNERS;
+    case ELTN_SCAN_SSE2:
+        return &SSE2_SCANNERS;
+#endif
+    default:
+        return &SCALAR_SCANNERS;
+    }
+}
+
+ELTN_Scan_Level ELTN_scan_set_level(ELTN_Scan_Level level) {
+    const Scanners* chosen = scanners_for(level);
+
+    atomic_store_explicit(&current, chosen, memory_order_release);
+    return chosen->level;
+}
+
+/*
+ * Pick the widest instruction set the first time any scanner runs,
+ * unless another thread has already picked one or set a level.
+ */
+static inline const Scanners* scanners(void) {
+    const Scanners* result =
+        atomic_load_explicit(&current, memory_order_acquire);
+
+    if (result == NULL) {
+        const Scanners* widest = scanners_for(ELTN_SCAN_AVX2);
+
+        if (atomic_compare_exchange_strong_explicit(&current, &result,
+                                                    widest,
+                                                    memory_order_acq_rel,
+                                                    memory_order_acquire)) {
+            result = widest;
+        }
+    }
+    return result;
+}
+
+ELTN_Scan_Level ELTN_scan_level(void) {
+    return scanners()->level;
+}
+
+/* ------------------------------- Scanners ------------------------------- */
+
+const char8_t* ELTN_scan_string_stop(const char8_t* ptr, const char8_t* end) {
+    return scanners()->string_stop(ptr, end);
+}
+
+const char8_t* ELTN_scan_non_blank(const char8_t* ptr, const char8_t* end) {
+    return scanners()->non_blank(ptr, end);
+}
+
+size_t ELTN_scan_count_lines(const char8_t* ptr, const char8_t* end,
+                             const char8_t** afterptr) {
+    return scanners()->count_lines(ptr, end, afterptr);
+}
+
+/*
+ * The C library's memchr() is already vectorized about as well as we could.
+ */
+const char8_t* ELTN_scan_line_end(const char8_t* ptr, const char8_t* end) {
+    const char8_t* nl = (ptr < end) ? memchr(ptr, '\n', end - ptr) : NULL;
+
+    return (nl != NULL) ? nl : end;
+}
@@ -0,0 +1,83 @@
+/*****************************************************************************
+ *
+ * Copyright 2025 Frank Mitchell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ ****************************************************************************/
+
+
+#ifndef __ELTN_SCAN
+#define __ELTN_SCAN
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "convert.h"
+
+/*
+ * Scanners that find the next interesting byte in [`ptr`, `end`), or
+ * return `end` if there is none.  Each uses the widest vector instructions
+ * the CPU supports, chosen on first use.
+ */
+
+/*
+ * The next byte that ends a run of short string text: a quote, a
+ * backslash, or a line break (ELTN_CLASS_STRING_STOP).
+ */
+const char8_t* ELTN_scan_string_stop(const char8_t* ptr, const char8_t* end);
+
+/*
+ * The next byte that isn't a blank, i.e. whitespace other than a newline
+ * (ELTN_CLASS_BLANK).
+ */
+const char8_t* ELTN_scan_non_blank(const char8_t* ptr, const char8_t* end);
+
+/*
+ * The next newline.
+ */
+const char8_t* ELTN_scan_line_end(const char8_t* ptr, const char8_t* end);
+
+/*
+ * The number of newlines in [`ptr`, `end`).  If there are any, sets
+ * `*afterptr` to the byte after the last one; otherwise leaves it alone.
+ */
+size_t ELTN_scan_count_lines(const char8_t* ptr, const char8_t* end,
+                             const char8_t** afterptr);
+
+/*
+ * Instruction sets a scanner may use, narrowest first.
+ */
+typedef enum ELTN_Scan_Level {
+    ELTN_SCAN_SCALAR = 0,
+    ELTN_SCAN_SSE2,
+    ELTN_SCAN_AVX2
+} ELTN_Scan_Level;
+
+/*
+ * The instruction set the scanners currently use.
+ */
+ELTN_Scan_Level ELTN_scan_level(void);
+
+/*
+ * Use `level` or, if the CPU doesn't support it, the widest one it does
+ * support below `level`.  Returns the level actually chosen.
+ */
+ELTN_Scan_Level ELTN_scan_set_level(ELTN_Scan_Level level);
+
+#endif /* __ELTN_SCAN */
@@ -26,69 +26,200 @@
 #include <string.h>
 #include "convert.h"
 #include "ealloc.h"
+#include "escan.h"
 #include "estring.h"
 
 
-static const char* append_octal(const char* instr, char* buf, size_t* buflenptr) {
-    char tmpbuf[4] = { '\0', '\0', '\0', '\0' };
+/*
+ * The value of a hexadecimal digit, or -1 if `c` isn't one.
+ */
+static int hex_value(char c) {
+    if (ELTN_CHAR_IS(c, ELTN_CLASS_DIGIT)) {
+        return c - '0';
+    }
+    if (ELTN_CHAR_IS(c, ELTN_CLASS_HEXDIGIT)) {
+        return (c | 0x20) - 'a' + 10;
+    }
+    return -1;
+}
+
+static const char* append_octal(const char* instr, const char* end,
+                                char* buf, size_t* buflenptr) {
     const char* result = instr;
+    unsigned int value = 0;
 
-    for (int i = 0; i < 3; i++) {
-        if (ELTN_is_octdigit(*result)) {
-            tmpbuf[i] = *result;
-            result++;
-        } else {
-            break;
-        }
+    while (result < end && result < instr + 3
+           && ELTN_CHAR_IS(*result, ELTN_CLASS_OCTDIGIT)) {
+        value = value * 8 + (*result - '0');
+        result++;
     }
-    buf[*buflenptr] = (char)(0xFF & strtol(tmpbuf, NULL, 8));
+    buf[*buflenptr] = (char)(0xFF & value);
     (*buflenptr) += 1;
     return result;
 }
 
-static const char* append_hex(const char* instr, char* buf, size_t* buflenptr) {
-    char tmpbuf[3];
-
-    if (!ELTN_is_hexdigit(instr[0]) || !ELTN_is_hexdigit(instr[1])) {
+static const char* append_hex(const char* instr, const char* end,
+                              char* buf, size_t* buflenptr) {
+    if (end - instr < 2 || hex_value(instr[0]) < 0
+        || hex_value(instr[1]) < 0) {
         /*
            TODO: raise error 
          */
         return instr;
     }
-    tmpbuf[0] = instr[0];
-    tmpbuf[1] = instr[1];
-    tmpbuf[2] = '\0';
-    buf[*buflenptr] = (char)(0xFF & strtol(tmpbuf, NULL, 16));
+    buf[*buflenptr] = (char)(hex_value(instr[0]) * 16 + hex_value(instr[1]));
     (*buflenptr) += 1;
     return instr + 2;
 }
 
-static const char* append_unicode(const char* instr,
-                                  char* buf, size_t* buflenptr) {
-    char32_t cp;
+static const char* append_unicode(const char* instr, const char* end,
+                                  char* buf, size_t bufsize,
+                                  size_t* buflenptr) {
+    const char* index = instr + 1;
+    char32_t cp = 0;
     size_t cplen;
-    const char* closebracket = strchr(instr, '}');
+    int digit;
 
-    if (*instr != '{' || closebracket == NULL) {
+    if (index >= end || *instr != '{') {
         /*
            TODO: flag error 
          */
         return instr;
     }
-    cp = (char32_t) strtol(instr + 1, NULL, 16);
+    while (index < end && (digit = hex_value(*index)) >= 0) {
+        if (cp > 0x7FFFFFF) {
+            return instr;
+        }
+        cp = cp * 16 + digit;
+        index++;
+    }
+    if (index >= end || *index != '}' || index == instr + 1) {
+        return instr;
+    }
 
-    cplen = C_Conv_codepoint_to_char8(cp, *buflenptr,
+    cplen = C_Conv_codepoint_to_char8(cp, bufsize - (*buflenptr),
                                       (char8_t *) buf + (*buflenptr));
     (*buflenptr) += cplen;
-    return closebracket + 1;
+    return index + 1;
+}
+
+/*
+ * Decode the escape sequence after a backslash at `instr`, and return
+ * where the text after it begins.
+ */
+static const char* append_escape(const char* instr, const char* end,
+                                 char* buf, size_t bufsize,
+                                 size_t* buflenptr) {
+    const char* index = instr;
+
+    switch (*index) {
+    case '\n':
+        buf[(*buflenptr)++] = '\n';
+        index++;
+        break;
+    case '\r':
+        buf[(*buflenptr)++] = '\n';
+        index++;
+        if (index < end && *index == '\n') {
+            index++;
+        }
+        break;
+    case 'a':
+        buf[(*buflenptr)++] = 0x07;
+        index++;
+        break;
+    case 'b':
+        buf[(*buflenptr)++] = 0x08;
+        index++;
+        break;
+    case 'f':
+        buf[(*buflenptr)++] = 0x0c;
+        index++;
+        break;
+    case 'n':
+        buf[(*buflenptr)++] = 0x0a;
+        index++;
+        break;
+    case 'r':
+        buf[(*buflenptr)++] = 0x0d;
+        index++;
+        break;
+    case 't':
+        buf[(*buflenptr)++] = 0x09;
+        index++;
+        break;
+    case 'v':
+        buf[(*buflenptr)++] = 0x0b;
+        index++;
+        break;
+    case 'x':
+        index = append_hex(index + 1, end, buf, buflenptr);
+        break;
+    case 'u':
+        index = append_unicode(index + 1, end, buf, bufsize, buflenptr);
+        break;
+    case 'z':
+        index++;
+        while (index < end && ELTN_is_space(*index)) {
+            index++;
+        }
+        break;
+    case '0':
+    case '1':
+    case '2':
+    case '3':
+    case '4':
+    case '5':
+    case '6':
+    case '7':
+        index = append_octal(index, end, buf, buflenptr);
+        break;
+    default:
+        buf[(*buflenptr)++] = *index;
+        index++;
+    }
+    return index;
+}
+
+/*
+ * The next quote, backslash, or line break in [`ptr`, `end`).
+ */
+static const char* next_stop(const char* ptr, const char* end) {
+    return (const char *)ELTN_scan_string_stop((const char8_t *)ptr,
+                                               (const char8_t *)end);
+}
+
+bool ELTN_quoted_string_body(const char* instr, const size_t inlen,
+                             const char** bodyptr, size_t* lenptr) {
+    const char* end = instr + inlen;
+    const char* stop;
+    char quotechar;
+
+    if (inlen < 2 || (*instr != '\'' && *instr != '\"')) {
+        return false;
+    }
+    quotechar = *instr;
+    for (stop = next_stop(instr + 1, end);
+         stop < end && *stop != quotechar && *stop != '\\';
+         stop = next_stop(stop + 1, end)) {
+        /* another quote character, or an (invalid) line break */
+    }
+    if (stop >= end || *stop != quotechar) {
+        return false;
+    }
+    (*bodyptr) = instr + 1;
+    (*lenptr) = stop - (instr + 1);
+    return true;
 }
 
 void ELTN_unescape_quoted_string(ELTN_Pool* h,
                                  const char* instr, const size_t inlen,
                                  char** outstrptr, size_t* outlenptr) {
-    char* bufptr = ELTN_alloc(h, inlen);
+    const size_t bufsize = inlen + 1;
+    char* bufptr = ELTN_alloc(h, bufsize);
     size_t buflen = 0;
     const char* index = instr;
+    const char* end = instr + inlen;
     char quotechar = '\0';
 
     if (bufptr == NULL) {
@@ -97,96 +228,32 @@ void ELTN_unescape_quoted_string(ELTN_Pool* h,
         return;
     }
 
-    if (*index == '\'' || *index == '\"') {
+    if (inlen > 0 && (*index == '\'' || *index == '\"')) {
         quotechar = *index;
         index++;
     }
-    while (index < instr + inlen && *index != quotechar) {
-        if (*index != '\\') {
-            bufptr[buflen] = *index;
-            buflen++;
-            index++;
-        } else {
+
+    /*
+     * Copy each run of plain text whole, stopping only at escapes and
+     * the closing quote.
+     */
+    while (index < end) {
+        const char* stop = next_stop(index, end);
+
+        if (stop > index) {
+            memcpy(bufptr + buflen, index, stop - index);
+            buflen += stop - index;
+        }
+        index = stop;
+        if (index >= end || *index == quotechar) {
+            break;
+        }
+        if (*index != '\\' || index + 1 >= end) {
+            bufptr[buflen++] = *index;
             index++;
-            switch (*index) {
-            case '\n':
-                bufptr[buflen] = '\n';
-                buflen++;
-                index++;
-                break;
-            case '\r':
-                bufptr[buflen] = '\n';
-                buflen++;
-                index++;
-                if (*index == '\n') {
-                    index++;
-                }
-                break;
-            case 'a':
-                bufptr[buflen] = 0x07;
-                buflen++;
-                index++;
-                break;
-            case 'b':
-                bufptr[buflen] = 0x08;
-                buflen++;
-                index++;
-                break;
-            case 'f':
-                bufptr[buflen] = 0x0c;
-                buflen++;
-                index++;
-                break;
-            case 'n':
-                bufptr[buflen] = 0x0a;
-                buflen++;
-                index++;
-                break;
-            case 'r':
-                bufptr[buflen] = 0x0d;
-                buflen++;
-                index++;
-                break;
-            case 't':
-                bufptr[buflen] = 0x09;
-                buflen++;
-                index++;
-                break;
-            case 'v':
-                bufptr[buflen] = 0x0b;
-                buflen++;
-                index++;
-                break;
-            case 'x':
-                index++;
-                index = append_hex(index, bufptr, &buflen);
-                break;
-            case 'u':
-                index++;
-                index = append_unicode(index, bufptr, &buflen);
-                break;
-            case 'z':
-                index++;
-                while (ELTN_is_space(*index)) {
-                    index++;
-                }
-                break;
-            case '0':
-            case '1':
-            case '2':
-            case '3':
-            case '4':
-            case '5':
-            case '6':
-            case '7':
-                index = append_octal(index, bufptr, &buflen);
-                break;
-            default:
-                bufptr[buflen] = *index;
-                buflen++;
-                index++;
-            }
+            continue;
         }
+        index = append_escape(index + 1, end, bufptr, bufsize, &buflen);
     }
 
     *outstrptr = bufptr;
@@ -199,7 +266,7 @@ void ELTN_unquote_long_string(ELTN_Pool* h,
     /*
        TODO: Wrong! 
      */
-    ELTN_new_string(outstrptr, outlenptr, instr, inlen);
+    ELTN_new_string_in_pool(h, outstrptr, outlenptr, instr, inlen);
 }
 
 void ELTN_trim_comment(ELTN_Pool* h, const char* instr, const size_t inlen,
@@ -207,7 +274,7 @@ void ELTN_trim_comment(ELTN_Pool* h, const char* instr, const size_t inlen,
     /*
        TODO: Wrong! 
      */
-    ELTN_new_string(outstrptr, outlenptr, instr, inlen);
+    ELTN_new_string_in_pool(h, outstrptr, outlenptr, instr, inlen);
 }
 
 bool ELTN_is_newline(const char* str, size_t len) {
@@ -226,169 +293,88 @@ bool ELTN_is_newline(const char* str, size_t len) {
     return false;
 }
 
+#define SPACE       ELTN_CLASS_SPACE
+#define BLANK       (ELTN_CLASS_SPACE | ELTN_CLASS_BLANK)
+#define STRING_STOP ELTN_CLASS_STRING_STOP
+#define NUMBER_PART ELTN_CLASS_NUMBER_PART
+#define SIGN        (ELTN_CLASS_NUMBER_PART | ELTN_CLASS_SIGN)
+#define DECIMAL     (ELTN_CLASS_DIGIT | ELTN_CLASS_HEXDIGIT \
+                     | ELTN_CLASS_NAME_PART | ELTN_CLASS_NUMBER_PART)
+#define OCTAL       (DECIMAL | ELTN_CLASS_OCTDIGIT)
+#define UNDERSCORE  (ELTN_CLASS_NAME_START | ELTN_CLASS_NAME_PART)
+#define LETTER      (ELTN_CLASS_LETTER | UNDERSCORE)
+#define EXP_LETTER  (LETTER | ELTN_CLASS_NUMBER_PART)
+#define HEX_LETTER  (EXP_LETTER | ELTN_CLASS_HEXDIGIT)
+
+/*
+ * Using a table because <ctype.h> functions depend on locale,
+ * while ELTN's idea of a letter doesn't.  Bytes not listed are in no class.
+ */
+const uint16_t ELTN_CHAR_CLASS[256] = {
+    ['\t'] = BLANK, ['\v'] = BLANK, ['\f'] = BLANK, [' '] = BLANK,
+    ['\n'] = SPACE | STRING_STOP, ['\r'] = BLANK | STRING_STOP,
+    ['"'] = STRING_STOP, ['\''] = STRING_STOP, ['\\'] = STRING_STOP,
+    ['+'] = SIGN, ['-'] = SIGN, ['.'] = NUMBER_PART,
+    ['0'] = OCTAL, ['1'] = OCTAL, ['2'] = OCTAL, ['3'] = OCTAL, ['4'] = OCTAL,
+    ['5'] = OCTAL, ['6'] = OCTAL, ['7'] = OCTAL, ['8'] = DECIMAL,
+    ['9'] = DECIMAL,
+    ['A'] = HEX_LETTER, ['B'] = HEX_LETTER, ['C'] = HEX_LETTER,
+    ['D'] = HEX_LETTER, ['E'] = HEX_LETTER, ['F'] = HEX_LETTER, ['G'] = LETTER,
+    ['H'] = LETTER, ['I'] = LETTER, ['J'] = LETTER, ['K'] = LETTER,
+    ['L'] = LETTER, ['M'] = LETTER, ['N'] = LETTER, ['O'] = LETTER,
+    ['P'] = EXP_LETTER, ['Q'] = LETTER, ['R'] = LETTER, ['S'] = LETTER,
+    ['T'] = LETTER, ['U'] = LETTER, ['V'] = LETTER, ['W'] = LETTER,
+    ['X'] = EXP_LETTER, ['Y'] = LETTER, ['Z'] = LETTER,
+    ['_'] = UNDERSCORE,
+    ['a'] = HEX_LETTER, ['b'] = HEX_LETTER, ['c'] = HEX_LETTER,
+    ['d'] = HEX_LETTER, ['e'] = HEX_LETTER, ['f'] = HEX_LETTER, ['g'] = LETTER,
+    ['h'] = LETTER, ['i'] = LETTER, ['j'] = LETTER, ['k'] = LETTER,
+    ['l'] = LETTER, ['m'] = LETTER, ['n'] = LETTER, ['o'] = LETTER,
+    ['p'] = EXP_LETTER, ['q'] = LETTER, ['r'] = LETTER, ['s'] = LETTER,
+    ['t'] = LETTER, ['u'] = LETTER, ['v'] = LETTER, ['w'] = LETTER,
+    ['x'] = EXP_LETTER, ['y'] = LETTER, ['z'] = LETTER,
+};
+
+#undef SPACE
+#undef BLANK
+#undef STRING_STOP
+#undef NUMBER_PART
+#undef SIGN
+#undef DECIMAL
+#undef OCTAL
+#undef UNDERSCORE
+#undef LETTER
+#undef EXP_LETTER
+#undef HEX_LETTER
+
 bool ELTN_is_space(uint32_t c) {
-    switch (c) {
-    case '\f':
-    case '\n':
-    case '\r':
-    case '\t':
-    case '\v':
-    case ' ':
-        return true;
-    default:
-        return false;
-    }
+    return c < 256 && ELTN_CHAR_IS(c, ELTN_CLASS_SPACE);
 }
 
 bool ELTN_is_letter(uint32_t c) {
-    /*
-     * Using a big switch statement because <ctype.h> functions
-     * depend on locale, while ELTN's idea of a letter doesn't.
-     */
-    switch (c) {
-    case 'A':
-    case 'B':
-    case 'C':
-    case 'D':
-    case 'E':
-    case 'F':
-    case 'G':
-    case 'H':
-    case 'I':
-    case 'J':
-    case 'K':
-    case 'L':
-    case 'M':
-    case 'N':
-    case 'O':
-    case 'P':
-    case 'Q':
-    case 'R':
-    case 'S':
-    case 'T':
-    case 'U':
-    case 'V':
-    case 'W':
-    case 'X':
-    case 'Y':
-    case 'Z':
-    case 'a':
-    case 'b':
-    case 'c':
-    case 'd':
-    case 'e':
-    case 'f':
-    case 'g':
-    case 'h':
-    case 'i':
-    case 'j':
-    case 'k':
-    case 'l':
-    case 'm':
-    case 'n':
-    case 'o':
-    case 'p':
-    case 'q':
-    case 'r':
-    case 's':
-    case 't':
-    case 'u':
-    case 'v':
-    case 'w':
-    case 'x':
-    case 'y':
-    case 'z':
-        return true;
-    default:
-        return false;
-    }
+    return c < 256 && ELTN_CHAR_IS(c, ELTN_CLASS_LETTER);
 }
 
 bool ELTN_is_digit(uint32_t c) {
-    switch (c) {
-    case '0':
-    case '1':
-    case '2':
-    case '3':
-    case '4':
-    case '5':
-    case '6':
-    case '7':
-    case '8':
-    case '9':
-        return true;
-    default:
-        return false;
-    }
+    return c < 256 && ELTN_CHAR_IS(c, ELTN_CLASS_DIGIT);
 }
 
 bool ELTN_is_hexdigit(uint32_t c) {
-    switch (c) {
-    case '0':
-    case '1':
-    case '2':
-    case '3':
-    case '4':
-    case '5':
-    case '6':
-    case '7':
-    case '8':
-    case '9':
-    case 'A':
-    case 'B':
-    case 'C':
-    case 'D':
-    case 'E':
-    case 'F':
-    case 'a':
-    case 'b':
-    case 'c':
-    case 'd':
-    case 'e':
-    case 'f':
-        return true;
-    default:
-        return false;
-    }
+    return c < 256 && ELTN_CHAR_IS(c, ELTN_CLASS_HEXDIGIT);
 }
 
 bool ELTN_is_octdigit(uint32_t c) {
-    switch (c) {
-    case '0':
-    case '1':
-    case '2':
-    case '3':
-    case '4':
-    case '5':
-    case '6':
-    case '7':
-        return true;
-    default:
-        return false;
-    }
+    return c < 256 && ELTN_CHAR_IS(c, ELTN_CLASS_OCTDIGIT);
 }
 
 bool ELTN_is_name_start(uint32_t c) {
-    return c == '_' || ELTN_is_letter(c);
+    return c < 256 && ELTN_CHAR_IS(c, ELTN_CLASS_NAME_START);
 }
 
 bool ELTN_is_name_part(uint32_t c) {
-    return ELTN_is_name_start(c) || ELTN_is_digit(c);
+    return c < 256 && ELTN_CHAR_IS(c, ELTN_CLASS_NAME_PART);
 }
 
 bool ELTN_is_number_part(uint32_t c) {
-    switch (c) {
-    case '.':
-    case '+':
-    case '-':
-    case 'e':
-    case 'E':
-    case 'p':
-    case 'P':
-    case 'x':
-    case 'X':
-        return true;
-    default:
-        return ELTN_is_hexdigit(c);
-    }
+    return c < 256 && ELTN_CHAR_IS(c, ELTN_CLASS_NUMBER_PART);
 }
@@ -33,6 +33,14 @@ void ELTN_unescape_quoted_string(ELTN_Pool * h,
                                  const char* instr, const size_t inlen,
                                  char** outstrptr, size_t* lenptr);
 
+/*
+ * If the quoted string `instr` has no escapes, point `*bodyptr` and
+ * `*lenptr` at the text between its quotes and return true; the text
+ * is then the string's value as is.
+ */
+bool ELTN_quoted_string_body(const char* instr, const size_t inlen,
+                             const char** bodyptr, size_t* lenptr);
+
 void ELTN_unquote_long_string(ELTN_Pool * h,
                               const char* instr, const size_t inlen,
                               char** outstrptr, size_t* lenptr);
@@ -40,6 +48,30 @@ void ELTN_unquote_long_string(ELTN_Pool * h,
 void ELTN_trim_comment(ELTN_Pool * h, const char* instr, const size_t inlen,
                        char** outstrptr, size_t* lenptr);
 
+/*
+ * Character classes, as bits in ELTN_CHAR_CLASS[].
+ */
+#define ELTN_CLASS_SPACE        0x0001
+#define ELTN_CLASS_BLANK        0x0002  /* space other than newline */
+#define ELTN_CLASS_LETTER       0x0004
+#define ELTN_CLASS_DIGIT        0x0008
+#define ELTN_CLASS_HEXDIGIT     0x0010
+#define ELTN_CLASS_OCTDIGIT     0x0020
+#define ELTN_CLASS_NAME_START   0x0040
+#define ELTN_CLASS_NAME_PART    0x0080
+#define ELTN_CLASS_NUMBER_PART  0x0100
+#define ELTN_CLASS_STRING_STOP  0x0200  /* ends a run of short string text */
+#define ELTN_CLASS_SIGN         0x0400
+
+extern const uint16_t ELTN_CHAR_CLASS[256];
+
+/*
+ * Whether byte `c` is in any of the classes in `mask`.
+ * EOF (-1) is in none of them.
+ */
+#define ELTN_CHAR_IS(c, mask) \
+    ((ELTN_CHAR_CLASS[(uint8_t)(c)] & (mask)) != 0)
+
 bool ELTN_is_space(uint32_t c);
 
 bool ELTN_is_letter(uint32_t c);
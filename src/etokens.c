@@ -0,0 +1,108 @@
+/*****************************************************************************
+ *
+ * Copyright 2025 Frank Mitchell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ ****************************************************************************/
+
+#include <stdint.h>
+
+#define  ELTN_CORE    1
+#include "eltn.h"
+#include "elexer.h"
+
+/*
+ * Lends the lexer the rest of an in-memory text as a single span.
+ */
+typedef struct Text_Source {
+    const char8_t* text;
+    size_t len;
+    size_t released;
+} Text_Source;
+
+static ssize_t text_next_span(void* state, size_t release, size_t offset,
+                              const char8_t** spanptr) {
+    Text_Source* src = (Text_Source *) state;
+    size_t start;
+
+    src->released += release;
+    start = src->released + offset;
+    if (start >= src->len) {
+        return 0;
+    }
+    (*spanptr) = src->text + start;
+    return src->len - start;
+}
+
+ELTN_API ssize_t ELTN_tokenize(const char* text, size_t len,
+                               size_t* offsetptr, ELTN_Token_Record* tokens,
+                               size_t max) {
+    const size_t base = (offsetptr == NULL) ? 0 : *offsetptr;
+    Text_Source src;
+    ELTN_Lexer* lexer;
+    size_t count = 0;
+    size_t end = base;
+
+    if (len > UINT32_MAX || base > len) {
+        return -1;
+    }
+    if (max == 0) {
+        return 0;
+    }
+    lexer = ELTN_Lexer_new_with_pool(NULL);
+    if (lexer == NULL) {
+        return -1;
+    }
+
+    /*
+     * Only where each token is matters, not its text.
+     */
+    src.text = (const char8_t *)text + base;
+    src.len = len - base;
+    src.released = 0;
+    ELTN_Lexer_set_span_source(lexer, text_next_span, &src);
+    ELTN_Lexer_set_skip_comments(lexer, true);
+
+    while (count < max) {
+        ELTN_Token token = ELTN_Lexer_next_token(lexer, NULL, NULL);
+        size_t offset;
+        size_t length;
+
+        if (token == ELTN_TOKEN_ERROR) {
+            ELTN_Lexer_free(lexer);
+            return -1;
+        }
+        ELTN_Lexer_token_extent(lexer, &offset, &length);
+        tokens[count].type = token;
+        tokens[count].offset = (uint32_t)(base + offset);
+        tokens[count].length = (uint32_t)length;
+        count++;
+        end = base + offset + length;
+        if (token == ELTN_TOKEN_EOF) {
+            break;
+        }
+    }
+    ELTN_Lexer_free(lexer);
+
+    if (offsetptr != NULL) {
+        (*offsetptr) = end;
+    }
+    return count;
+}
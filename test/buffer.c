@@ -21,6 +21,7 @@
  */
 
 #include <errno.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -31,6 +32,7 @@
 
 #define BUFFER_SIZE     64
 #define BUFFER_INCR     3
+#define INIT_BUFFER_SIZE 1024
 
 typedef struct Test_Buffer {
     const char8_t* buf;
@@ -70,6 +72,48 @@ static int Test_Reader(void* ud, char** strptr, size_t* sizeptr) {
     return 0;
 }
 
+static int lend_count = 0;
+static int release_count = 0;
+
+static void Test_Release(void* ud, const char* text, size_t size) {
+    release_count++;
+}
+
+static int Test_Lender(void* ud, const char** strptr, size_t* sizeptr,
+                       ELTN_Release* releaseptr) {
+    Test_Buffer* self = (Test_Buffer *) ud;
+    size_t old_idx = self->idx;
+
+    if (self->idx >= self->len) {
+        (*sizeptr) = 0;
+        (*strptr) = NULL;
+        return self->error;
+    }
+    self->idx += BUFFER_INCR;
+    if (self->idx > self->len) {
+        self->idx = self->len;
+    }
+    lend_count++;
+
+    (*sizeptr) = self->idx - old_idx;
+    (*strptr) = (const char *)self->buf + old_idx;
+    (*releaseptr) = Test_Release;
+    return 0;
+}
+
+static int alloc_count = 0;
+
+static void* Counting_Alloc(void* state, void* ptr, size_t size) {
+    if (size == 0) {
+        free(ptr);
+        return NULL;
+    }
+    if (ptr == NULL) {
+        alloc_count++;
+    }
+    return realloc(ptr, size);
+}
+
 static void read_all_buffer(ELTN_Buffer* buffer, char8_t* outbuf, size_t outlen) {
     int i = 0;
 
@@ -216,12 +260,328 @@ void buffer_ring_resize() {
     ELTN_Buffer_free(buffer);
 }
 
+void buffer_borrow() {
+    ELTN_Pool* pool = NULL;
+    ELTN_Buffer* buffer = NULL;
+    const char* data = "this text stays where it is.";
+    const int datalen = strlen(data);
+    char8_t outbuf[BUFFER_SIZE];
+
+    ELTN_Pool_new_with_alloc(&pool, Counting_Alloc, NULL);
+    buffer = ELTN_Buffer_new_with_pool(pool);
+    ELTN_Pool_release(&pool);
+    alloc_count = 0;
+
+    lok(buffer != NULL);
+    lequal(datalen, (int)ELTN_Buffer_borrow(buffer, data, datalen));
+    lequal(datalen, (int)ELTN_Buffer_length(buffer));
+    lok(ELTN_Buffer_is_closed(buffer));
+    lok(!ELTN_Buffer_is_empty(buffer));
+    lequal(-1, (int)ELTN_Buffer_write(buffer, "more", 4));
+    lequal(-1, (int)ELTN_Buffer_borrow(buffer, data, datalen));
+
+    memset(outbuf, 0, sizeof(outbuf));
+    read_all_buffer(buffer, outbuf, sizeof(outbuf));
+    lsequal(data, (const char *)outbuf);
+    lok(ELTN_Buffer_is_empty(buffer));
+    lequal(0, alloc_count);
+
+    ELTN_Buffer_free(buffer);
+}
+
+void buffer_read_lent() {
+    ELTN_Pool* pool = NULL;
+    ELTN_Buffer* buffer = NULL;
+    Test_Buffer tb;
+    const char8_t* data = (const char8_t *)"this text is lent three bytes at a time.";
+    char8_t outbuf[BUFFER_SIZE];
+
+    ELTN_Pool_new_with_alloc(&pool, Counting_Alloc, NULL);
+    buffer = ELTN_Buffer_new_with_pool(pool);
+    ELTN_Pool_release(&pool);
+    alloc_count = 0;
+    lend_count = 0;
+    release_count = 0;
+
+    Test_Buffer_init(&tb, data, 0);
+    lequal(BUFFER_INCR, (int)ELTN_Buffer_read_lent(buffer, Test_Lender, &tb));
+    lequal(1, lend_count);
+    lequal(0, release_count);
+    lequal(-1, (int)ELTN_Buffer_borrow(buffer, "more", 4));
+
+    memset(outbuf, 0, sizeof(outbuf));
+    read_all_buffer(buffer, outbuf, sizeof(outbuf));
+    lsequal((const char *)data, (const char *)outbuf);
+    lok(ELTN_Buffer_is_empty(buffer));
+    lok(ELTN_Buffer_is_closed(buffer));
+    lequal(14, lend_count);
+    lequal(lend_count, release_count);
+    lequal(0, alloc_count);
+
+    ELTN_Buffer_free(buffer);
+}
+
+void buffer_read_lent_free() {
+    ELTN_Buffer* buffer = ELTN_Buffer_new_with_pool(NULL);
+    Test_Buffer tb;
+
+    lend_count = 0;
+    release_count = 0;
+
+    Test_Buffer_init(&tb, (const char8_t *)"abcdefg", 0);
+    lequal(BUFFER_INCR, (int)ELTN_Buffer_read_lent(buffer, Test_Lender, &tb));
+    lequal('a', ELTN_Buffer_next_char(buffer, true));
+    lequal('b', ELTN_Buffer_next_char(buffer, true));
+    lequal('c', ELTN_Buffer_next_char(buffer, true));
+    lequal(0, release_count);
+    lequal('d', ELTN_Buffer_next_char(buffer, false));
+    lequal(1, release_count);
+
+    ELTN_Buffer_free(buffer);
+    lequal(2, lend_count);
+    lequal(2, release_count);
+}
+
+void buffer_borrow_not_empty() {
+    ELTN_Buffer* buffer = ELTN_Buffer_new_with_pool(NULL);
+
+    lequal(3, (int)ELTN_Buffer_write(buffer, "abc", 3));
+    lequal(-1, (int)ELTN_Buffer_borrow(buffer, "def", 3));
+    lok(!ELTN_Buffer_is_closed(buffer));
+
+    ELTN_Buffer_free(buffer);
+}
+
+typedef struct Producer {
+    ELTN_Buffer* buffer;
+    const char* data;
+    size_t len;
+    ssize_t written;
+} Producer;
+
+static void* Producer_run(void* state) {
+    Producer* self = (Producer *) state;
+    size_t i;
+
+    /*
+     * Write in uneven pieces, some larger than the buffer itself.
+     */
+    for (i = 0; i < self->len; i += 37) {
+        size_t n = (self->len - i < 37) ? self->len - i : 37;
+        ssize_t result = ELTN_Buffer_write(self->buffer, self->data + i, n);
+
+        if (result < 0) {
+            break;
+        }
+        self->written += result;
+    }
+    ELTN_Buffer_close(self->buffer);
+    return NULL;
+}
+
+void buffer_synchronized() {
+    ELTN_Buffer* buffer = ELTN_Buffer_new_with_pool(NULL);
+    char data[4096];
+    char outbuf[4096];
+    Producer producer;
+    pthread_t thread;
+    size_t nread = 0;
+    bool bounded = true;
+
+    for (size_t i = 0; i < sizeof(data); i++) {
+        data[i] = 'a' + (i % 26);
+    }
+
+    lok(ELTN_Buffer_set_max_capacity(buffer, 16));
+    lequal(16, (int)ELTN_Buffer_max_capacity(buffer));
+    lok(ELTN_Buffer_set_synchronized(buffer, true));
+    lok(ELTN_Buffer_is_synchronized(buffer));
+
+    producer.buffer = buffer;
+    producer.data = data;
+    producer.len = sizeof(data);
+    producer.written = 0;
+    lequal(0, pthread_create(&thread, NULL, Producer_run, &producer));
+
+    while (nread < sizeof(outbuf)) {
+        int32_t c = ELTN_Buffer_next_char(buffer, true);
+
+        if (c < 0) {
+            break;
+        }
+        outbuf[nread++] = (char)c;
+        bounded = bounded && ELTN_Buffer_capacity(buffer) <= 16;
+    }
+    pthread_join(thread, NULL);
+
+    lequal((int)sizeof(data), (int)producer.written);
+    lequal((int)sizeof(data), (int)nread);
+    lok(memcmp(data, outbuf, sizeof(data)) == 0);
+    lok(bounded);
+    lequal(-1, (int)ELTN_Buffer_next_char(buffer, true));
+
+    ELTN_Buffer_free(buffer);
+}
+
+void buffer_max_capacity() {
+    ELTN_Buffer* buffer = ELTN_Buffer_new_with_pool(NULL);
+
+    lok(ELTN_Buffer_set_max_capacity(buffer, 8));
+    lequal(8, (int)ELTN_Buffer_capacity(buffer));
+    lok(!ELTN_Buffer_set_capacity(buffer, 9));
+    lequal(7, (int)ELTN_Buffer_write(buffer, "abcdefg", 7));
+    lequal(-1, (int)ELTN_Buffer_write(buffer, "h", 1));
+    lok(!ELTN_Buffer_set_max_capacity(buffer, 4));
+    lequal(8, (int)ELTN_Buffer_max_capacity(buffer));
+    lok(ELTN_Buffer_set_max_capacity(buffer, 0));
+    lequal(1, (int)ELTN_Buffer_write(buffer, "h", 1));
+    lequal(8, (int)ELTN_Buffer_length(buffer));
+
+    ELTN_Buffer_free(buffer);
+}
+
+void buffer_write_nb() {
+    ELTN_Buffer* buffer = ELTN_Buffer_new_with_pool(NULL);
+
+    lok(ELTN_Buffer_set_max_capacity(buffer, 8));
+    lequal(5, (int)ELTN_Buffer_write_nb(buffer, "abcde", 5));
+    lequal(2, (int)ELTN_Buffer_write_nb(buffer, "fghij", 5));
+    lequal(0, (int)ELTN_Buffer_write_nb(buffer, "hij", 3));
+    lequal(7, (int)ELTN_Buffer_length(buffer));
+
+    lequal('a', ELTN_Buffer_next_char(buffer, true));
+    lequal('b', ELTN_Buffer_next_char(buffer, true));
+    lequal(2, (int)ELTN_Buffer_write_nb(buffer, "hij", 3));
+    lequal(0, (int)ELTN_Buffer_write_nb(buffer, "j", 1));
+
+    ELTN_Buffer_close(buffer);
+    lequal(-1, (int)ELTN_Buffer_write_nb(buffer, "j", 1));
+
+    ELTN_Buffer_free(buffer);
+}
+
+void buffer_write_timed() {
+    ELTN_Buffer* buffer = ELTN_Buffer_new_with_pool(NULL);
+
+    lok(ELTN_Buffer_set_max_capacity(buffer, 8));
+    lok(ELTN_Buffer_set_synchronized(buffer, true));
+    lequal(7, (int)ELTN_Buffer_write_timed(buffer, "abcdefghij", 10, 10));
+    lequal(0, (int)ELTN_Buffer_write_timed(buffer, "hij", 3, 10));
+    lequal(0, (int)ELTN_Buffer_write_timed(buffer, "hij", 3, 0));
+
+    lequal('a', ELTN_Buffer_next_char(buffer, true));
+    lequal(1, (int)ELTN_Buffer_write_timed(buffer, "hij", 3, 10));
+    lequal(7, (int)ELTN_Buffer_length(buffer));
+
+    ELTN_Buffer_close(buffer);
+    lequal(-1, (int)ELTN_Buffer_write_timed(buffer, "ij", 2, 10));
+
+    ELTN_Buffer_free(buffer);
+}
+
+void buffer_next_span() {
+    ELTN_Buffer* buffer = ELTN_Buffer_new_with_pool(NULL);
+    const char8_t* span = NULL;
+    char more[BUFFER_SIZE];
+
+    lok(ELTN_Buffer_set_capacity(buffer, 8));
+    lequal(6, (int)ELTN_Buffer_write(buffer, "abcdef", 6));
+    lequal(6, (int)ELTN_Buffer_next_span(buffer, 0, 0, &span));
+    lok(strncmp("abcdef", (const char *)span, 6) == 0);
+
+    /*
+     * The ring wraps; the span ends at the end of the ring.
+     */
+    lequal(2, (int)ELTN_Buffer_next_span(buffer, 4, 0, &span));
+    lok(strncmp("ef", (const char *)span, 2) == 0);
+    lequal(5, (int)ELTN_Buffer_write(buffer, "ghijk", 5));
+    lequal(4, (int)ELTN_Buffer_next_span(buffer, 0, 0, &span));
+    lok(strncmp("efgh", (const char *)span, 4) == 0);
+
+    /*
+     * Growing the ring leaves the span handed out intact.
+     */
+    memset(more, 'x', sizeof(more));
+    lequal(BUFFER_SIZE, (int)ELTN_Buffer_write(buffer, more, BUFFER_SIZE));
+    lok(strncmp("efgh", (const char *)span, 4) == 0);
+    lequal(3 + BUFFER_SIZE, (int)ELTN_Buffer_next_span(buffer, 4, 0, &span));
+    lok(strncmp("ijkxx", (const char *)span, 5) == 0);
+
+    /*
+     * A span may start past bytes handed out but not released.
+     */
+    lequal(BUFFER_SIZE, (int)ELTN_Buffer_next_span(buffer, 0, 3, &span));
+    lok(span[0] == 'x');
+
+    ELTN_Buffer_close(buffer);
+    lequal(0, (int)ELTN_Buffer_next_span(buffer, 3 + BUFFER_SIZE, 0, &span));
+    lok(span == NULL);
+
+    ELTN_Buffer_free(buffer);
+}
+
+void buffer_mirrored() {
+    ELTN_Buffer* buffer = ELTN_Buffer_new_with_pool(NULL);
+    const char8_t* span = NULL;
+    size_t capacity;
+    char* text;
+
+    if (!ELTN_Buffer_set_mirrored(buffer, true)) {
+        /* not supported here */
+        lok(!ELTN_Buffer_is_mirrored(buffer));
+        ELTN_Buffer_free(buffer);
+        return;
+    }
+    lok(ELTN_Buffer_is_mirrored(buffer));
+    capacity = ELTN_Buffer_capacity(buffer);
+    lok(capacity >= INIT_BUFFER_SIZE);
+
+    text = (char *)malloc(capacity);
+    for (size_t i = 0; i < capacity; i++) {
+        text[i] = 'a' + (i % 26);
+    }
+
+    /*
+     * Move the head near the end of the ring, then write across the end.
+     */
+    lequal((int)capacity - 10, (int)ELTN_Buffer_write(buffer, text, capacity - 10));
+    lequal((int)capacity - 10,
+           (int)ELTN_Buffer_next_span(buffer, 0, 0, &span));
+    lequal(-1, (int)ELTN_Buffer_next_span(buffer, capacity - 10, 0, &span));
+    lequal(100, (int)ELTN_Buffer_write(buffer, text, 100));
+    lequal(100, (int)ELTN_Buffer_next_span(buffer, 0, 0, &span));
+    lok(memcmp(text, span, 100) == 0);
+    lok(!ELTN_Buffer_set_mirrored(buffer, false));
+
+    /*
+     * Growing keeps the ring mirrored.
+     */
+    lequal((int)capacity, (int)ELTN_Buffer_write(buffer, text, capacity));
+    lok(ELTN_Buffer_capacity(buffer) > capacity);
+    lok(memcmp(text, span, 100) == 0);
+    lequal(100 + (int)capacity, (int)ELTN_Buffer_next_span(buffer, 0, 0, &span));
+    lok(memcmp(text, span + 100, capacity) == 0);
+
+    free(text);
+    ELTN_Buffer_free(buffer);
+}
+
 int main(int argc, char* argv[]) {
     lrun("test_buffer_smoke", buffer_smoke);
     lrun("test_buffer_read", buffer_read);
     lrun("test_buffer_write", buffer_write);
     lrun("test_buffer_ring_cycle", buffer_ring_cycle);
     lrun("test_buffer_ring_resize", buffer_ring_resize);
+    lrun("test_buffer_borrow", buffer_borrow);
+    lrun("test_buffer_borrow_not_empty", buffer_borrow_not_empty);
+    lrun("test_buffer_read_lent", buffer_read_lent);
+    lrun("test_buffer_read_lent_free", buffer_read_lent_free);
+    lrun("test_buffer_max_capacity", buffer_max_capacity);
+    lrun("test_buffer_synchronized", buffer_synchronized);
+    lrun("test_buffer_write_nb", buffer_write_nb);
+    lrun("test_buffer_write_timed", buffer_write_timed);
+    lrun("test_buffer_next_span", buffer_next_span);
+    lrun("test_buffer_mirrored", buffer_mirrored);
     lresults();
     return lfails != 0;
 }
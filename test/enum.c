@@ -25,6 +25,7 @@
 
 void event_name() {
     lsequal("ELTN_ERROR", ELTN_Event_name(ELTN_ERROR));
+    lsequal("ELTN_NEED_MORE_INPUT", ELTN_Event_name(ELTN_NEED_MORE_INPUT));
     lsequal("ELTN_KEY_INTEGER", ELTN_Event_name(ELTN_KEY_INTEGER));
     lsequal("ELTN_STREAM_END", ELTN_Event_name(ELTN_STREAM_END));
 }
@@ -33,11 +34,23 @@ void error_name() {
     lsequal("ELTN_ERR_UNKNOWN", ELTN_Error_name(ELTN_ERR_UNKNOWN));
     lsequal("ELTN_OK", ELTN_Error_name(ELTN_OK));
     lsequal("ELTN_ERR_DUPLICATE_KEY", ELTN_Error_name(ELTN_ERR_DUPLICATE_KEY));
+    lsequal("ELTN_ERR_LIMIT_EXCEEDED",
+            ELTN_Error_name(ELTN_ERR_LIMIT_EXCEEDED));
+    lsequal("ELTN_ERR_READ", ELTN_Error_name(ELTN_ERR_READ));
+}
+
+void token_name() {
+    lsequal("ELTN_TOKEN_ERROR", ELTN_Token_name(ELTN_TOKEN_ERROR));
+    lsequal("ELTN_TOKEN_CURLY_OPEN", ELTN_Token_name(ELTN_TOKEN_CURLY_OPEN));
+    lsequal("ELTN_TOKEN_INTEGER", ELTN_Token_name(ELTN_TOKEN_INTEGER));
+    lsequal("ELTN_TOKEN_NEED_MORE", ELTN_Token_name(ELTN_TOKEN_NEED_MORE));
+    lsequal("", ELTN_Token_name(ELTN_TOKEN_NEED_MORE + 1));
 }
 
 int main(int argc, char* argv[]) {
     lrun("test_event_name", event_name);
     lrun("test_error_name", error_name);
+    lrun("test_token_name", token_name);
     lresults();
     return lfails != 0;
 }
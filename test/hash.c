@@ -0,0 +1,68 @@
+/*
+ * Copyright 2025 Frank Mitchell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <string.h>
+#include "minctest.h"
+#include "eltn.h"
+
+static uint64_t hash(const char* str, uint64_t seed) {
+    return ELTN_hash(str, strlen(str), seed);
+}
+
+/*
+ * Values from the reference implementation of MurmurHash64A.
+ */
+void known_values() {
+    const char* fox = "The quick brown fox jumps over the lazy dog";
+
+    lok(hash("", 0) == 0x0000000000000000ULL);
+    lok(hash("a", 0) == 0x071717d2d36b6b11ULL);
+    lok(hash("name", 0) == 0xd4c943cba60c270bULL);
+    lok(hash("abcdefgh", 0) == 0xafdb0257ff41aa98ULL);
+    lok(hash("hello, world!", 0) == 0xd18abe154a2a9637ULL);
+    lok(hash(fox, 0) == 0x5589ca33042a861bULL);
+
+    lok(hash("", 0x9747b28c) == 0x8397626cd6895052ULL);
+    lok(hash("a", 0x9747b28c) == 0xe96b6245652273aeULL);
+    lok(hash("name", 0x9747b28c) == 0x19b77f952a86c6d9ULL);
+    lok(hash("abcdefgh", 0x9747b28c) == 0x617b517726694ebaULL);
+    lok(hash("hello, world!", 0x9747b28c) == 0xce8378ef1bd9c100ULL);
+    lok(hash(fox, 0x9747b28c) == 0x029a7747a564bd84ULL);
+}
+
+void unaligned() {
+    char buf[64];
+    const char* text = "name = 'value'";
+    const size_t len = strlen(text);
+
+    for (size_t i = 0; i < 8; i++) {
+        memcpy(buf + i, text, len);
+        lok(ELTN_hash(buf + i, len, 7) == hash(text, 7));
+    }
+}
+
+int main(int argc, char* argv[]) {
+    lrun("test_hash_known_values", known_values);
+    lrun("test_hash_unaligned", unaligned);
+    lresults();
+    return lfails != 0;
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright 2025 Frank Mitchell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "minctest.h"
+#include "eintern.h"
+
+static int add(Intern_Table* t, const char* key) {
+    const size_t len = strlen(key);
+
+    return Intern_Table_add(t, key, len, Intern_Table_hash(t, key, len));
+}
+
+static int find(Intern_Table* t, const char* key) {
+    const size_t len = strlen(key);
+
+    return Intern_Table_find(t, key, len, Intern_Table_hash(t, key, len));
+}
+
+void happy_path() {
+    Intern_Table* t = Intern_Table_new_with_pool(NULL);
+    const char* str = NULL;
+    size_t len = 0;
+
+    lequal(0, add(t, "foo"));
+    lequal(1, add(t, "bar"));
+    lequal(2, add(t, ""));
+    lequal(0, add(t, "foo"));
+    lequal(3, (int)Intern_Table_size(t));
+
+    lequal(1, find(t, "bar"));
+    lequal(2, find(t, ""));
+    lequal(-1, find(t, "ba"));
+    lequal(-1, find(t, "quux"));
+
+    str = Intern_Table_string(t, 1, &len);
+    lsequal("bar", str);
+    lequal(3, (int)len);
+    lok(Intern_Table_string(t, 3, &len) == NULL);
+    lok(Intern_Table_string(t, -1, &len) == NULL);
+
+    Intern_Table_free(t);
+}
+
+void resize() {
+    Intern_Table* t = Intern_Table_new_with_pool(NULL);
+    const char* first = NULL;
+    char key[16];
+    size_t len = 0;
+
+    lequal(0, add(t, "key0"));
+    first = Intern_Table_string(t, 0, &len);
+
+    for (int i = 1; i < 100; i++) {
+        snprintf(key, sizeof(key), "key%d", i);
+        lequal(i, add(t, key));
+    }
+    lequal(100, (int)Intern_Table_size(t));
+
+    for (int i = 0; i < 100; i++) {
+        snprintf(key, sizeof(key), "key%d", i);
+        lequal(i, find(t, key));
+    }
+
+    /*
+     * Growing the table doesn't move the strings.
+     */
+    lok(first == Intern_Table_string(t, 0, &len));
+    lsequal("key0", first);
+
+    Intern_Table_free(t);
+}
+
+void reseed() {
+    Intern_Table* t = Intern_Table_new_with_pool(NULL);
+
+    lequal(0, add(t, "foo"));
+    lequal(1, add(t, "bar"));
+    lok(Intern_Table_hash(t, "foo", 3) == ELTN_hash("foo", 3, 0));
+
+    Intern_Table_set_seed(t, 42);
+    lok(Intern_Table_seed(t) == 42);
+    lok(Intern_Table_hash(t, "foo", 3) == ELTN_hash("foo", 3, 42));
+    lequal(0, find(t, "foo"));
+    lequal(1, find(t, "bar"));
+    lequal(2, add(t, "baz"));
+
+    Intern_Table_free(t);
+}
+
+int main(int argc, char* argv[]) {
+    lrun("test_intern_happy_path", happy_path);
+    lrun("test_intern_resize", resize);
+    lrun("test_intern_reseed", reseed);
+    lresults();
+    return lfails != 0;
+}
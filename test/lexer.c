@@ -38,37 +38,45 @@ typedef struct Mock_Source {
     const char8_t* buf;
     const char8_t* ptr;
     size_t len;
+    size_t span;
 } Mock_Source;
 
 static void set_debug(bool debug) {
     __debug = debug;
 }
 
-static int32_t Mock_Source_next_char(void* state, bool consume) {
+static ssize_t Mock_Source_next_span(void* state, size_t release,
+                                     size_t offset, const char8_t** spanptr) {
     Mock_Source* self = (Mock_Source *) state;
-    char8_t result;
+    size_t left;
 
-    if (self->ptr >= self->buf + self->len) {
-        return -1;
+    self->ptr += release;
+    left = self->buf + self->len - self->ptr - offset;
+    if (left == 0) {
+        (*spanptr) = NULL;
+        return 0;
     }
-    result = *(self->ptr);
-    if (consume) {
-        self->ptr++;
-    }
-    return result;
+    (*spanptr) = self->ptr + offset;
+    return (left < self->span) ? left : self->span;
 }
 
-static ELTN_Lexer* set_up(Mock_Source* self, const char* data) {
+static ELTN_Lexer* set_up_spans(Mock_Source* self, const char* data,
+                                size_t span) {
     self->buf = (const char8_t *)data;
     self->ptr = (const char8_t *)data;
     self->len = strlen(data);
+    self->span = span;
 
     ELTN_Lexer* lexer = ELTN_Lexer_new_with_pool(NULL);
 
-    ELTN_Lexer_set_char_source(lexer, Mock_Source_next_char, self);
+    ELTN_Lexer_set_span_source(lexer, Mock_Source_next_span, self);
     return lexer;
 }
 
+static ELTN_Lexer* set_up(Mock_Source* self, const char* data) {
+    return set_up_spans(self, data, strlen(data));
+}
+
 static void assert_token(ELTN_Lexer* lexer,
                          ELTN_Token exptoken,
                          const char* exptokstr, int expline, int expcol) {
@@ -297,6 +305,27 @@ void lexer_strings_2() {
     ELTN_Lexer_free(lexer);
 }
 
+void lexer_strings_3() {
+    ELTN_Lexer* lexer;
+    Mock_Source source;
+    const char* data =
+        "'a string long enough to cross a few vector widths \\\\' "
+        "\"ends in \\\\\" 'skip\\z\n\n   lines' 'not\nthis'";
+
+    lexer = set_up(&source, data);
+
+    lok(lexer != NULL);
+
+    assert_token(lexer, ELTN_TOKEN_STRING,
+                 "'a string long enough to cross a few vector widths \\\\'",
+                 1, 1);
+    assert_token(lexer, ELTN_TOKEN_STRING, "\"ends in \\\\\"", 1, 56);
+    assert_token(lexer, ELTN_TOKEN_STRING, "'skip\\z\n\n   lines'", 1, 69);
+    assert_token(lexer, ELTN_TOKEN_INVALID, "'not", 3, 11);
+
+    ELTN_Lexer_free(lexer);
+}
+
 void lexer_incomplete_string() {
     ELTN_Lexer* lexer;
     Mock_Source source;
@@ -383,6 +412,32 @@ void lexer_invalid_keywords() {
     ELTN_Lexer_free(lexer);
 }
 
+void lexer_keyword_near_misses() {
+    ELTN_Lexer* lexer;
+    Mock_Source source;
+    const char* data = "tru nill an doo If whilE returm x _ true nil false";
+
+    lexer = set_up(&source, data);
+
+    lok(lexer != NULL);
+
+    assert_token(lexer, ELTN_TOKEN_NAME, "tru", 1, 1);
+    assert_token(lexer, ELTN_TOKEN_NAME, "nill", 1, 5);
+    assert_token(lexer, ELTN_TOKEN_NAME, "an", 1, 10);
+    assert_token(lexer, ELTN_TOKEN_NAME, "doo", 1, 13);
+    assert_token(lexer, ELTN_TOKEN_NAME, "If", 1, 17);
+    assert_token(lexer, ELTN_TOKEN_NAME, "whilE", 1, 20);
+    assert_token(lexer, ELTN_TOKEN_NAME, "returm", 1, 26);
+    assert_token(lexer, ELTN_TOKEN_NAME, "x", 1, 33);
+    assert_token(lexer, ELTN_TOKEN_NAME, "_", 1, 35);
+    assert_token(lexer, ELTN_TOKEN_BOOLEAN_TRUE, "true", 1, 37);
+    assert_token(lexer, ELTN_TOKEN_NIL, "nil", 1, 42);
+    assert_token(lexer, ELTN_TOKEN_BOOLEAN_FALSE, "false", 1, 46);
+    assert_token(lexer, ELTN_TOKEN_EOF, "", 1, strlen(data) + 1);
+
+    ELTN_Lexer_free(lexer);
+}
+
 void lexer_comment() {
     ELTN_Lexer* lexer;
     Mock_Source source;
@@ -404,6 +459,40 @@ void lexer_comment() {
     ELTN_Lexer_free(lexer);
 }
 
+void lexer_comment_skipped() {
+    ELTN_Lexer* lexer;
+    Mock_Source source;
+    const char* data =
+        "  \t  -- this is a short comment\n"
+        "  -- this is also a comment\r\n"
+        "--[[ long ]] --\n"
+        "                                          --[ not long\n"
+        "--[==[ a ]=] b ]] ]==]]==] --[=[ ]=\n]] ]=]"
+        "\"this isn't\" --";
+
+    lexer = set_up_spans(&source, data, 5);
+    ELTN_Lexer_set_skip_comments(lexer, true);
+
+    lok(lexer != NULL);
+
+    assert_token(lexer, ELTN_TOKEN_COMMENT, "--", 1, 6);
+    assert_token(lexer, ELTN_TOKEN_COMMENT, "--", 2, 3);
+    assert_token(lexer, ELTN_TOKEN_LONG_COMMENT, "--[[", 3, 1);
+    assert_token(lexer, ELTN_TOKEN_COMMENT, "--", 3, 14);
+    assert_token(lexer, ELTN_TOKEN_COMMENT, "--[", 4, 43);
+    assert_token(lexer, ELTN_TOKEN_LONG_COMMENT, "--[==[", 5, 1);
+    assert_token(lexer, ELTN_TOKEN_SQUARE_CLOSE, "]", 5, 23);
+    assert_token(lexer, ELTN_TOKEN_EQUALS, "=", 5, 24);
+    assert_token(lexer, ELTN_TOKEN_EQUALS, "=", 5, 25);
+    assert_token(lexer, ELTN_TOKEN_SQUARE_CLOSE, "]", 5, 26);
+    assert_token(lexer, ELTN_TOKEN_LONG_COMMENT, "--[=[", 5, 28);
+    assert_token(lexer, ELTN_TOKEN_STRING, "\"this isn't\"", 6, 7);
+    assert_token(lexer, ELTN_TOKEN_COMMENT, "--", 6, 20);
+    assert_token(lexer, ELTN_TOKEN_EOF, "", 6, 22);
+
+    ELTN_Lexer_free(lexer);
+}
+
 void lexer_long_comment() {
     ELTN_Lexer* lexer;
     Mock_Source source;
@@ -483,6 +572,56 @@ void lexer_long_string() {
     ELTN_Lexer_free(lexer);
 }
 
+void lexer_long_string_2() {
+    ELTN_Lexer* lexer;
+    Mock_Source source;
+    const char* data =
+        "[==[a]=]b]===]c]]\r\nd]]=]]==] x\n"
+        "[[]]";
+
+    lexer = set_up_spans(&source, data, 4);
+
+    lok(lexer != NULL);
+
+    assert_token(lexer, ELTN_TOKEN_LONG_STRING,
+                 "[==[a]=]b]===]c]]\nd]]=]]==]", 1, 1);
+    assert_token(lexer, ELTN_TOKEN_NAME, "x", 2, 11);
+    assert_token(lexer, ELTN_TOKEN_LONG_STRING, "[[]]", 3, 1);
+    assert_token(lexer, ELTN_TOKEN_EOF, "", 3, 5);
+
+    ELTN_Lexer_free(lexer);
+}
+
+void lexer_long_string_huge() {
+    ELTN_Lexer* lexer;
+    Mock_Source source;
+    const size_t size = 200 * 1024;
+    char* data = malloc(size + 1);
+    char* tokstr;
+    size_t toklen;
+
+    memset(data, 'x', size);
+    memcpy(data, "[[", 2);
+    memcpy(data + size - 8, "]] nil ", 7);
+    data[size - 1] = 'z';
+    data[size] = '\0';
+
+    lexer = set_up_spans(&source, data, 1000);
+
+    lok(lexer != NULL);
+
+    lequal(ELTN_TOKEN_LONG_STRING, ELTN_Lexer_next_token(lexer, NULL, NULL));
+    ELTN_Lexer_token_string(lexer, &tokstr, &toklen);
+    lequal((int)(size - 6), (int)toklen);
+    lok(memcmp(data, tokstr, toklen) == 0);
+    ELTN_free_string(tokstr);
+
+    assert_token(lexer, ELTN_TOKEN_NIL, "nil", 1, size - 4);
+    assert_token(lexer, ELTN_TOKEN_NAME, "z", 1, size);
+
+    ELTN_Lexer_free(lexer);
+    free(data);
+}
 
 void lexer_long_string_not() {
     ELTN_Lexer* lexer;
@@ -514,15 +653,15 @@ void lexer_numbers_good() {
 
     lok(lexer != NULL);
 
-    assert_token(lexer, ELTN_TOKEN_NUMBER, "0", 1, 1);
-    assert_token(lexer, ELTN_TOKEN_NUMBER, "-0", 1, 3);
-    assert_token(lexer, ELTN_TOKEN_NUMBER, "1", 1, 6);
-    assert_token(lexer, ELTN_TOKEN_NUMBER, "-3", 1, 8);
+    assert_token(lexer, ELTN_TOKEN_INTEGER, "0", 1, 1);
+    assert_token(lexer, ELTN_TOKEN_INTEGER, "-0", 1, 3);
+    assert_token(lexer, ELTN_TOKEN_INTEGER, "1", 1, 6);
+    assert_token(lexer, ELTN_TOKEN_INTEGER, "-3", 1, 8);
     assert_token(lexer, ELTN_TOKEN_NUMBER, "3e8", 1, 11);
-    assert_token(lexer, ELTN_TOKEN_NUMBER, "0x3e8", 1, 15);
-    assert_token(lexer, ELTN_TOKEN_NUMBER, "007", 1, 21);
+    assert_token(lexer, ELTN_TOKEN_INTEGER, "0x3e8", 1, 15);
+    assert_token(lexer, ELTN_TOKEN_INTEGER, "007", 1, 21);
     assert_token(lexer, ELTN_TOKEN_NUMBER, "0x3e8p+8", 1, 25);
-    assert_token(lexer, ELTN_TOKEN_NUMBER, "1000", 1, 34);
+    assert_token(lexer, ELTN_TOKEN_INTEGER, "1000", 1, 34);
     assert_token(lexer, ELTN_TOKEN_NUMBER, "-.5", 1, 39);
     assert_token(lexer, ELTN_TOKEN_NUMBER, "3.14159", 1, 43);
     assert_token(lexer, ELTN_TOKEN_NUMBER, "0x0.1E", 1, 51);
@@ -544,14 +683,14 @@ void lexer_numbers_bad() {
 
     assert_token(lexer, ELTN_TOKEN_INVALID, "-", 1, 1);
     assert_token(lexer, ELTN_TOKEN_INVALID, "-.", 1, 3);
-    assert_token(lexer, ELTN_TOKEN_NUMBER, "23", 1, 6);
+    assert_token(lexer, ELTN_TOKEN_INTEGER, "23", 1, 6);
     assert_token(lexer, ELTN_TOKEN_NAME, "skidoo", 1, 8);
     assert_token(lexer, ELTN_TOKEN_INVALID, "3df", 1, 15);
-    assert_token(lexer, ELTN_TOKEN_NUMBER, "100", 1, 19);
+    assert_token(lexer, ELTN_TOKEN_INTEGER, "100", 1, 19);
     assert_token(lexer, ELTN_TOKEN_COMMA, ",", 1, 22);
-    assert_token(lexer, ELTN_TOKEN_NUMBER, "000", 1, 23);
+    assert_token(lexer, ELTN_TOKEN_INTEGER, "000", 1, 23);
     assert_token(lexer, ELTN_TOKEN_INVALID, "+", 1, 27);
-    assert_token(lexer, ELTN_TOKEN_NUMBER, "3", 1, 28);
+    assert_token(lexer, ELTN_TOKEN_INTEGER, "3", 1, 28);
     assert_token(lexer, ELTN_TOKEN_NAME, "twelve", 1, 30);
     assert_token(lexer, ELTN_TOKEN_EOF, "", 1, 36);
 
@@ -562,6 +701,120 @@ void lexer_numbers_bad() {
 /*
  * Main function: runs all the tests
  */
+void lexer_spans() {
+    const char* data =
+        "-- a comment\r\n"
+        "name = { flag = true, n = -22.5e3, [\"key\"] = 'it\\'s',\n"
+        "  s = \"line one\\\nline two\", [[long\nstring]],\n"
+        "  --[==[ long\ncomment ]==] x0 = 0x20; }\n";
+    const size_t spans[] = { 1, 2, 3, 7 };
+    ELTN_Lexer* whole;
+    Mock_Source whole_source;
+
+    whole = set_up(&whole_source, data);
+
+    for (int i = 0; i < sizeof(spans) / sizeof(spans[0]); i++) {
+        ELTN_Lexer* lexer;
+        Mock_Source source;
+        ELTN_Token token;
+
+        ELTN_Lexer_free(whole);
+        whole = set_up(&whole_source, data);
+        lexer = set_up_spans(&source, data, spans[i]);
+
+        do {
+            char* expstr;
+            char* tokstr;
+            size_t explen;
+            size_t toklen;
+            int expline, expcol;
+            int line, col;
+            ELTN_Token exptoken;
+
+            exptoken = ELTN_Lexer_next_token(whole, &expline, &expcol);
+            ELTN_Lexer_token_string(whole, &expstr, &explen);
+            token = ELTN_Lexer_next_token(lexer, &line, &col);
+            ELTN_Lexer_token_string(lexer, &tokstr, &toklen);
+
+            lequal(exptoken, token);
+            lsequal(expstr, tokstr);
+            lequal(expline, line);
+            lequal(expcol, col);
+
+            ELTN_free_string(expstr);
+            ELTN_free_string(tokstr);
+        } while (token != ELTN_TOKEN_EOF && token != ELTN_TOKEN_INVALID);
+
+        lequal(ELTN_TOKEN_EOF, token);
+        ELTN_Lexer_free(lexer);
+    }
+    ELTN_Lexer_free(whole);
+}
+
+void lexer_lazy_position() {
+    ELTN_Lexer* lexer;
+    Mock_Source source;
+    const char* data = "x = [[a\nb]]\n  yy = 'c\\\nd'\r\n\n\tz";
+    const int expected[][2] = {
+        {1, 1}, {1, 3}, {1, 5}, {3, 3}, {3, 6}, {3, 8}, {6, 2}, {6, 3}
+    };
+
+    for (size_t span = 1; span < 8; span++) {
+        lexer = set_up_spans(&source, data, span);
+        for (int i = 0; i < sizeof(expected) / sizeof(expected[0]); i++) {
+            int line = 0;
+            int col = 0;
+
+            ELTN_Lexer_next_token(lexer, NULL, NULL);
+            ELTN_Lexer_token_position(lexer, &line, &col);
+            lequal(expected[i][0], line);
+            lequal(expected[i][1], col);
+        }
+        ELTN_Lexer_free(lexer);
+    }
+}
+
+void lexer_token_view() {
+    ELTN_Lexer* lexer;
+    Mock_Source source;
+    const char* data = "name 12.5 [[long\r\nstring]] other";
+    const char* str;
+    size_t len;
+
+    lexer = set_up_spans(&source, data, 16);
+
+    lok(lexer != NULL);
+
+    /*
+     * Tokens within one span are views of the input ...
+     */
+    lequal(ELTN_TOKEN_NAME, ELTN_Lexer_next_token(lexer, NULL, NULL));
+    ELTN_Lexer_token_view(lexer, &str, &len);
+    lok(str == data);
+    lequal(4, (int)len);
+
+    lequal(ELTN_TOKEN_NUMBER, ELTN_Lexer_next_token(lexer, NULL, NULL));
+    ELTN_Lexer_token_view(lexer, &str, &len);
+    lok(str == data + 5);
+    lequal(4, (int)len);
+
+    /*
+     * ... but not tokens that leave bytes out or cross into another span.
+     */
+    lequal(ELTN_TOKEN_LONG_STRING, ELTN_Lexer_next_token(lexer, NULL, NULL));
+    ELTN_Lexer_token_view(lexer, &str, &len);
+    lok(str < data || str >= data + strlen(data));
+    lequal(15, (int)len);
+    lok(strncmp("[[long\nstring]]", str, len) == 0);
+
+    lequal(ELTN_TOKEN_NAME, ELTN_Lexer_next_token(lexer, NULL, NULL));
+    ELTN_Lexer_token_view(lexer, &str, &len);
+    lequal(5, (int)len);
+    lok(strncmp("other", str, len) == 0);
+
+    ELTN_Lexer_free(lexer);
+}
+
 int main(int argc, char* argv[]) {
     lrun("test_lexer_semicolon", lexer_semicolon);
     lrun("test_lexer_equals", lexer_equals);
@@ -577,17 +830,25 @@ int main(int argc, char* argv[]) {
     lrun("test_lexer_boolean_false_positive", lexer_boolean_false_positive);
     lrun("test_lexer_strings", lexer_strings);
     lrun("test_lexer_strings_2", lexer_strings_2);
+    lrun("test_lexer_strings_3", lexer_strings_3);
     lrun("test_lexer_incomplete_string", lexer_incomplete_string);
     lrun("test_lexer_invalid_characters", lexer_invalid_characters);
     lrun("test_lexer_invalid_keywords", lexer_invalid_keywords);
+    lrun("test_lexer_keyword_near_misses", lexer_keyword_near_misses);
     lrun("test_lexer_comment", lexer_comment);
+    lrun("test_lexer_comment_skipped", lexer_comment_skipped);
     lrun("test_lexer_long_comment", lexer_long_comment);
     lrun("test_lexer_long_comment_2", lexer_long_comment_2);
     lrun("test_lexer_long_comment_not", lexer_long_comment_not);
     lrun("test_lexer_long_string", lexer_long_string);
+    lrun("test_lexer_long_string_2", lexer_long_string_2);
+    lrun("test_lexer_long_string_huge", lexer_long_string_huge);
     lrun("test_lexer_long_string_not", lexer_long_string_not);
     lrun("test_lexer_numbers_good", lexer_numbers_good);
     lrun("test_lexer_numbers_bad", lexer_numbers_bad);
+    lrun("test_lexer_spans", lexer_spans);
+    lrun("test_lexer_lazy_position", lexer_lazy_position);
+    lrun("test_lexer_token_view", lexer_token_view);
     lresults();
     return lfails != 0;
 }
@@ -0,0 +1,138 @@
+/*
+ * Copyright 2025 Frank Mitchell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "minctest.h"
+#include "enumber.h"
+
+static ELTN_Numeral parse(const char* str, int64_t* intptr, double* numptr) {
+    return ELTN_parse_numeral(str, strlen(str), intptr, numptr);
+}
+
+static void assert_integer(const char* str, int64_t expected) {
+    int64_t i = 0;
+    double d = 0;
+
+    lequal(ELTN_NUMERAL_INTEGER, parse(str, &i, &d));
+    lok(i == expected);
+    lok(d == (double)expected);
+}
+
+static void assert_float(const char* str, double expected) {
+    double d = 0;
+
+    lequal(ELTN_NUMERAL_FLOAT, parse(str, NULL, &d));
+    lok(d == expected);
+    lok(signbit(d) == signbit(expected));
+}
+
+void number_integers() {
+    assert_integer("0", 0);
+    assert_integer("-0", 0);
+    assert_integer("007", 7);
+    assert_integer("1000", 1000);
+    assert_integer("-3", -3);
+    assert_integer("9223372036854775807", INT64_MAX);
+    assert_integer("-9223372036854775808", INT64_MIN);
+    assert_integer("0x3e8", 1000);
+    assert_integer("0XfF", 255);
+    assert_integer("0x7fffffffffffffff", INT64_MAX);
+    assert_integer("0xffffffffffffffff", -1);
+    assert_integer("0x10000000000000001", 1);
+    assert_integer("-0x10", -16);
+}
+
+void number_floats() {
+    assert_float("9223372036854775808", 9223372036854775808.0);
+    assert_float("-9223372036854775809", -9223372036854775809.0);
+    assert_float("3e8", 3e8);
+    assert_float("-.5", -0.5);
+    assert_float("5.", 5.0);
+    assert_float("-0.0", -0.0);
+    assert_float("3.14159", 3.14159);
+    assert_float("1E-5", 1e-5);
+    assert_float("12e25", 12e25);
+    assert_float("0.000001234", 0.000001234);
+    assert_float("1e-400000000000", 0.0);
+    assert_float("0x0.1E", 0x0.1Ep0);
+    assert_float("0xA23p-4", 0xA23p-4);
+    assert_float("0X1.921FB54442D18P+1", 0X1.921FB54442D18P+1);
+    assert_float("0x3e8p+8", 0x3e8p+8);
+    assert_float("0x.8", 0.5);
+    assert_float("0x1.fffffffffffffffffp0", 0x1.fffffffffffffffffp0);
+    assert_float("2.2250738585072011e-308", 2.2250738585072011e-308);
+    assert_float("4.9e-324", 4.9e-324);
+    assert_float("1.7976931348623157e308", 1.7976931348623157e308);
+    assert_float("123456789012345678901234567890", 123456789012345678901234567890.0);
+}
+
+void number_invalid() {
+    const char* bad[] = {
+        "", "-", ".", "-.", "0x", "0x.", "0x.p1", "1e", "1e+", "1.2.3",
+        "3df", "1e999", "-1e999", "0x1p99999", "12abc", "0xg", "1p4", "+1",
+        "--1", "1-2", "0x1e+1"
+    };
+
+    for (int i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        lequal(ELTN_NUMERAL_INVALID, parse(bad[i], NULL, NULL));
+    }
+}
+
+/*
+ * Random decimals must come out exactly as strtod() has them.
+ */
+void number_matches_strtod() {
+    char str[64];
+    double d;
+
+    srand(42);
+    for (int i = 0; i < 20000; i++) {
+        const int digits = 1 + rand() % 20;
+        const int exponent = rand() % 700 - 350;
+        int len = 0;
+
+        for (int j = 0; j < digits; j++) {
+            str[len++] = '0' + rand() % 10;
+            if (j == digits / 2) {
+                str[len++] = '.';
+            }
+        }
+        len += sprintf(str + len, "e%d", exponent);
+        if (parse(str, NULL, &d) == ELTN_NUMERAL_FLOAT) {
+            lok(d == strtod(str, NULL));
+        } else {
+            lok(isinf(strtod(str, NULL)));
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    lrun("test_number_integers", number_integers);
+    lrun("test_number_floats", number_floats);
+    lrun("test_number_invalid", number_invalid);
+    lrun("test_number_matches_strtod", number_matches_strtod);
+    lresults();
+    return lfails != 0;
+}
@@ -20,8 +20,11 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
+#include <errno.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 #include "minctest.h"
 #include "eltn.h"
 
@@ -205,7 +208,7 @@ void complex_document() {
     lok(ELTN_Parser_has_next(parser));
 
     ELTN_Parser_next(parser);
-    lequal(ELTN_VALUE_NUMBER, ELTN_Parser_event(parser));
+    lequal(ELTN_VALUE_INTEGER, ELTN_Parser_event(parser));
     assert_text_equal(parser, "22");
     assert_string_equal(parser, "22");
     lequal(22, (int)ELTN_Parser_integer(parser));
@@ -256,7 +259,7 @@ void complex_document() {
     lok(ELTN_Parser_has_next(parser));
 
     ELTN_Parser_next(parser);
-    lequal(ELTN_VALUE_NUMBER, ELTN_Parser_event(parser));
+    lequal(ELTN_VALUE_INTEGER, ELTN_Parser_event(parser));
     assert_text_equal(parser, "0x20");
     assert_string_equal(parser, "0x20");
     lequal(32, (int)ELTN_Parser_integer(parser));
@@ -336,12 +339,869 @@ void complex_document() {
     ELTN_Parser_free(parser);
 }
 
+void in_place_document() {
+    const char* data = "key = { flag = true, string = \"foo\" }";
+    ELTN_Parser* parser = ELTN_Parser_new();
+
+    lequal((int)strlen(data),
+           (int)ELTN_Parser_read_string_in_place(parser, data, strlen(data)));
+    lok(ELTN_Buffer_is_closed(ELTN_Parser_buffer(parser)));
+
+    ELTN_Parser_next(parser);
+    lequal(ELTN_DEF_NAME, ELTN_Parser_event(parser));
+    assert_string_equal(parser, "key");
+
+    ELTN_Parser_next(parser);
+    lequal(ELTN_TABLE_START, ELTN_Parser_event(parser));
+
+    ELTN_Parser_next(parser);
+    lequal(ELTN_KEY_STRING, ELTN_Parser_event(parser));
+    assert_string_equal(parser, "flag");
+
+    ELTN_Parser_next(parser);
+    lequal(ELTN_VALUE_TRUE, ELTN_Parser_event(parser));
+
+    ELTN_Parser_next(parser);
+    lequal(ELTN_KEY_STRING, ELTN_Parser_event(parser));
+    assert_string_equal(parser, "string");
+
+    ELTN_Parser_next(parser);
+    lequal(ELTN_VALUE_STRING, ELTN_Parser_event(parser));
+    assert_text_equal(parser, "\"foo\"");
+    assert_string_equal(parser, "foo");
+
+    ELTN_Parser_next(parser);
+    lequal(ELTN_TABLE_END, ELTN_Parser_event(parser));
+
+    ELTN_Parser_next(parser);
+    lequal(ELTN_STREAM_END, ELTN_Parser_event(parser));
+    lok(!ELTN_Parser_has_next(parser));
+
+    ELTN_Parser_free(parser);
+}
+
+static void assert_simple_definition(ELTN_Parser* parser) {
+    ELTN_Parser_next(parser);
+    lequal(ELTN_DEF_NAME, ELTN_Parser_event(parser));
+    assert_string_equal(parser, "key");
+
+    ELTN_Parser_next(parser);
+    lequal(ELTN_VALUE_STRING, ELTN_Parser_event(parser));
+    assert_string_equal(parser, "value");
+
+    ELTN_Parser_next(parser);
+    lequal(ELTN_STREAM_END, ELTN_Parser_event(parser));
+    lok(!ELTN_Parser_has_next(parser));
+}
+
+void read_path_document() {
+    const char* data = "key = 'value'\n";
+    char path[] = "/tmp/eltn-test-XXXXXX";
+    int fd = mkstemp(path);
+    ELTN_Parser* parser = ELTN_Parser_new();
+
+    lok(fd >= 0);
+    lequal((int)strlen(data), (int)write(fd, data, strlen(data)));
+    close(fd);
+
+    lequal((int)strlen(data), (int)ELTN_Parser_read_path(parser, path));
+    assert_simple_definition(parser);
+
+    ELTN_Parser_free(parser);
+    unlink(path);
+}
+
+void read_fd_pipe() {
+    const char* data = "key = 'value'\n";
+    int fds[2];
+    ELTN_Parser* parser = ELTN_Parser_new();
+
+    lequal(0, pipe(fds));
+    lequal((int)strlen(data), (int)write(fds[1], data, strlen(data)));
+    close(fds[1]);
+
+    lequal((int)strlen(data), (int)ELTN_Parser_read_fd(parser, fds[0]));
+    assert_simple_definition(parser);
+
+    ELTN_Parser_free(parser);
+    close(fds[0]);
+}
+
+void read_path_missing() {
+    ELTN_Parser* parser = ELTN_Parser_new();
+
+    lequal(-1, (int)ELTN_Parser_read_path(parser, "/nonexistent/eltn"));
+
+    ELTN_Parser_free(parser);
+}
+
+static ELTN_Event parse_to_end(ELTN_Parser* parser) {
+    while (ELTN_Parser_has_next(parser)) {
+        ELTN_Parser_next(parser);
+    }
+    return ELTN_Parser_event(parser);
+}
+
+void read_path_directory() {
+    ELTN_Parser* parser = ELTN_Parser_new();
+
+    /*
+     * Reading a directory fails on the first read(); the parser must not
+     * keep the descriptor.
+     */
+    lequal(-1, (int)ELTN_Parser_read_path(parser, "."));
+    lequal(ELTN_ERROR, parse_to_end(parser));
+    lequal(ELTN_ERR_READ, ELTN_Parser_error_code(parser));
+
+    ELTN_Parser_free(parser);
+}
+
+/*
+ * Lends one chunk, then fails.
+ */
+static int Failing_Lender(void* state, const char** strptr, size_t* sizeptr,
+                          ELTN_Release* releaseptr) {
+    int* calls = (int *)state;
+
+    (*releaseptr) = NULL;
+    if ((*calls)++ == 0) {
+        (*strptr) = "key = { 1, 2";
+        (*sizeptr) = strlen(*strptr);
+        return 0;
+    }
+    (*strptr) = NULL;
+    (*sizeptr) = 0;
+    return EIO;
+}
+
+void read_lent_error() {
+    ELTN_Parser* parser = ELTN_Parser_new();
+    int calls = 0;
+
+    lequal(12, (int)ELTN_Parser_read_lent(parser, Failing_Lender, &calls));
+    lequal(ELTN_ERROR, parse_to_end(parser));
+    lequal(ELTN_ERR_READ, ELTN_Parser_error_code(parser));
+    lequal(2, calls);
+
+    ELTN_Parser_free(parser);
+}
+
+void limit_token_length() {
+    const char* data = "a = 'short'; b = 'a rather longer string'";
+    ELTN_Parser* parser = ELTN_Parser_new();
+
+    ELTN_Parser_set_max_token_length(parser, 16);
+    lequal(16, (int)ELTN_Parser_max_token_length(parser));
+    ELTN_Parser_read_string(parser, data, strlen(data));
+
+    lequal(ELTN_ERROR, parse_to_end(parser));
+    lequal(ELTN_ERR_LIMIT_EXCEEDED, ELTN_Parser_error_code(parser));
+    lequal(1, ELTN_Parser_error_line(parser));
+    lequal(18, ELTN_Parser_error_column(parser));
+
+    ELTN_Parser_free(parser);
+}
+
+void limit_depth() {
+    const char* ok = "a = { b = { c = {} } }";
+    const char* deep = "a = { b = { c = { d = {} } } }";
+    ELTN_Parser* parser = ELTN_Parser_new();
+
+    ELTN_Parser_set_max_depth(parser, 3);
+    lequal(3, ELTN_Parser_max_depth(parser));
+    ELTN_Parser_read_string(parser, ok, strlen(ok));
+    lequal(ELTN_STREAM_END, parse_to_end(parser));
+    ELTN_Parser_free(parser);
+
+    parser = ELTN_Parser_new();
+    ELTN_Parser_set_max_depth(parser, 3);
+    ELTN_Parser_read_string(parser, deep, strlen(deep));
+    lequal(ELTN_ERROR, parse_to_end(parser));
+    lequal(ELTN_ERR_LIMIT_EXCEEDED, ELTN_Parser_error_code(parser));
+    lequal(3, (int)ELTN_Parser_depth(parser));
+    lequal(23, ELTN_Parser_error_column(parser));
+    ELTN_Parser_free(parser);
+}
+
+void limit_document_size() {
+    const char* data = "a = 1; b = 2; c = 3";
+    ELTN_Parser* parser = ELTN_Parser_new();
+
+    ELTN_Parser_set_max_document_size(parser, strlen(data));
+    lequal((int)strlen(data), (int)ELTN_Parser_max_document_size(parser));
+    ELTN_Parser_read_string(parser, data, strlen(data));
+    lequal(ELTN_STREAM_END, parse_to_end(parser));
+    ELTN_Parser_free(parser);
+
+    parser = ELTN_Parser_new();
+    ELTN_Parser_set_max_document_size(parser, strlen(data) - 1);
+    ELTN_Parser_read_string(parser, data, strlen(data));
+    lequal(ELTN_ERROR, parse_to_end(parser));
+    lequal(ELTN_ERR_LIMIT_EXCEEDED, ELTN_Parser_error_code(parser));
+    ELTN_Parser_free(parser);
+}
+
+static int Big_Chunk_Reader(void* state, char** strptr, size_t* sizeptr) {
+    const char* chunk = "a = 'this chunk is larger than the buffer may grow'";
+    int* calls = (int *)state;
+
+    (*calls)++;
+    if (*calls > 1) {
+        (*strptr) = NULL;
+        (*sizeptr) = 0;
+        return 0;
+    }
+    (*sizeptr) = strlen(chunk);
+    (*strptr) = (char *)malloc(*sizeptr);
+    memcpy(*strptr, chunk, *sizeptr);
+    return 0;
+}
+
+void limit_buffer_capacity() {
+    ELTN_Parser* parser = ELTN_Parser_new();
+    int calls = 0;
+
+    lok(ELTN_Buffer_set_max_capacity(ELTN_Parser_buffer(parser), 16));
+    lequal(-1, (int)ELTN_Parser_read(parser, Big_Chunk_Reader, &calls));
+    lequal(ELTN_ERROR, parse_to_end(parser));
+    lequal(ELTN_ERR_LIMIT_EXCEEDED, ELTN_Parser_error_code(parser));
+
+    ELTN_Parser_free(parser);
+}
+
+void incremental_document() {
+    const char* data =
+        "-- settings\n"
+        "key1 = { flag = true, number = 22, string = \"foo\" };\n"
+        "key2 = { [\"long key\"] = [==[bar\nbaz]==], 0x20, 3.5e2 }\n";
+    const size_t len = strlen(data);
+    const size_t pieces[] = { 1, 3, 7, 64 };
+
+    for (int i = 0; i < sizeof(pieces) / sizeof(pieces[0]); i++) {
+        ELTN_Parser* whole = ELTN_Parser_new();
+        ELTN_Parser* parser = ELTN_Parser_new();
+        ELTN_Buffer* buffer = ELTN_Parser_buffer(parser);
+        size_t written = 0;
+        int suspended = 0;
+
+        ELTN_Parser_read_string(whole, data, len);
+        ELTN_Parser_set_incremental(parser, true);
+        lok(ELTN_Parser_is_incremental(parser));
+
+        while (ELTN_Parser_has_next(whole)) {
+            char* expstr;
+            char* str;
+            size_t explen, slen;
+
+            ELTN_Parser_next(whole);
+            ELTN_Parser_next(parser);
+            while (ELTN_Parser_event(parser) == ELTN_NEED_MORE_INPUT) {
+                size_t n = (len - written < pieces[i])
+                    ? len - written : pieces[i];
+
+                suspended++;
+                if (n == 0) {
+                    ELTN_Buffer_close(buffer);
+                } else {
+                    ELTN_Buffer_write(buffer, data + written, n);
+                    written += n;
+                }
+                ELTN_Parser_next(parser);
+            }
+            lequal(ELTN_Parser_event(whole), ELTN_Parser_event(parser));
+            ELTN_Parser_string(whole, &expstr, &explen);
+            ELTN_Parser_string(parser, &str, &slen);
+            lsequal(expstr, str);
+            free(expstr);
+            free(str);
+        }
+        lequal(ELTN_STREAM_END, ELTN_Parser_event(parser));
+        lok(suspended > 0);
+
+        ELTN_Parser_free(whole);
+        ELTN_Parser_free(parser);
+    }
+}
+
+void incremental_error() {
+    const char* data = "key1 = { flag = true,, }";
+    ELTN_Parser* parser = ELTN_Parser_new();
+    ELTN_Buffer* buffer = ELTN_Parser_buffer(parser);
+
+    ELTN_Parser_set_incremental(parser, true);
+    ELTN_Parser_next(parser);
+    lequal(ELTN_NEED_MORE_INPUT, ELTN_Parser_event(parser));
+    lok(ELTN_Parser_has_next(parser));
+
+    ELTN_Buffer_write(buffer, data, 13);
+    ELTN_Parser_next(parser);
+    lequal(ELTN_DEF_NAME, ELTN_Parser_event(parser));
+    ELTN_Parser_next(parser);
+    lequal(ELTN_TABLE_START, ELTN_Parser_event(parser));
+    ELTN_Parser_next(parser);
+    lequal(ELTN_NEED_MORE_INPUT, ELTN_Parser_event(parser));
+    lequal(ELTN_OK, ELTN_Parser_error_code(parser));
+
+    ELTN_Buffer_write(buffer, data + 13, strlen(data) - 13);
+    ELTN_Parser_next(parser);
+    lequal(ELTN_KEY_STRING, ELTN_Parser_event(parser));
+    ELTN_Parser_next(parser);
+    lequal(ELTN_VALUE_TRUE, ELTN_Parser_event(parser));
+    ELTN_Parser_next(parser);
+    lequal(ELTN_ERROR, ELTN_Parser_event(parser));
+    lequal(ELTN_ERR_UNEXPECTED_TOKEN, ELTN_Parser_error_code(parser));
+    lequal(22, ELTN_Parser_error_column(parser));
+
+    ELTN_Parser_free(parser);
+}
+
+/*
+ * Feed `data` to an incremental parser one byte at a time, and check
+ * where it reports an error.
+ */
+static void check_error_bytewise(const char* data, int line, int column) {
+    ELTN_Parser* parser = ELTN_Parser_new();
+    ELTN_Buffer* buffer = ELTN_Parser_buffer(parser);
+    size_t written = 0;
+
+    ELTN_Parser_set_incremental(parser, true);
+    while (ELTN_Parser_has_next(parser)) {
+        ELTN_Parser_next(parser);
+        if (ELTN_Parser_event(parser) != ELTN_NEED_MORE_INPUT) {
+            continue;
+        }
+        if (data[written] == '\0') {
+            ELTN_Buffer_close(buffer);
+        } else {
+            ELTN_Buffer_write(buffer, data + written, 1);
+            written++;
+        }
+    }
+    lequal(ELTN_ERROR, ELTN_Parser_event(parser));
+    lequal(line, (int)ELTN_Parser_error_line(parser));
+    lequal(column, (int)ELTN_Parser_error_column(parser));
+
+    ELTN_Parser_free(parser);
+}
+
+void incremental_error_position() {
+    check_error_bytewise("a = 1\nb = 2\nc = 3\n}", 4, 1);
+    check_error_bytewise("a = { 1\nx }", 2, 1);
+    check_error_bytewise("a = 'x'\n\n  b = --[[\n]] }", 4, 4);
+}
+
+typedef struct Writer_Thread {
+    ELTN_Buffer* buffer;
+    const char* data;
+} Writer_Thread;
+
+static void* Writer_Thread_run(void* state) {
+    Writer_Thread* self = (Writer_Thread *) state;
+    const size_t len = strlen(self->data);
+
+    for (size_t i = 0; i < len; i += 5) {
+        ELTN_Buffer_write(self->buffer, self->data + i,
+                          (len - i < 5) ? len - i : 5);
+    }
+    ELTN_Buffer_close(self->buffer);
+    return NULL;
+}
+
+/*
+ * A pool that remembers what it handed out, to catch memory freed
+ * through the wrong allocator.
+ */
+#define MAX_TRACKED 256
+
+static void* tracked[MAX_TRACKED];
+static int foreign_frees = 0;
+
+static void* Tracking_Alloc(void* state, void* ptr, size_t size) {
+    int slot = -1;
+
+    for (int i = 0; i < MAX_TRACKED && ptr != NULL; i++) {
+        if (tracked[i] == ptr) {
+            slot = i;
+            break;
+        }
+    }
+    if (ptr != NULL && slot < 0) {
+        foreign_frees++;
+        return NULL;
+    }
+    if (size == 0) {
+        if (slot >= 0) {
+            tracked[slot] = NULL;
+        }
+        free(ptr);
+        return NULL;
+    }
+    void* result = realloc(ptr, size);
+
+    if (result == NULL) {
+        return NULL;
+    }
+    if (slot < 0) {
+        for (slot = 0; slot < MAX_TRACKED && tracked[slot] != NULL; slot++) {
+        }
+        if (slot == MAX_TRACKED) {
+            free(result);
+            return NULL;
+        }
+    }
+    tracked[slot] = result;
+    return result;
+}
+
+void comment_events_with_pool() {
+    const char* data = "-- one\nkey = --[[ two ]] 1 -- three\n";
+    ELTN_Pool* pool = NULL;
+    ELTN_Parser* parser = NULL;
+    int ncomments = 0;
+
+    memset(tracked, 0, sizeof(tracked));
+    foreign_frees = 0;
+    ELTN_Pool_new_with_alloc(&pool, Tracking_Alloc, NULL);
+    parser = ELTN_Parser_new_with_pool(pool);
+    ELTN_Pool_release(&pool);
+
+    ELTN_Parser_set_include_comments(parser, true);
+    read_string(parser, data);
+    while (ELTN_Parser_has_next(parser)) {
+        ELTN_Parser_next(parser);
+        if (ELTN_Parser_event(parser) == ELTN_COMMENT) {
+            ncomments++;
+        }
+    }
+    lequal(ELTN_STREAM_END, ELTN_Parser_event(parser));
+    lequal(3, ncomments);
+    ELTN_Parser_free(parser);
+
+    lequal(0, foreign_frees);
+    for (int i = 0; i < MAX_TRACKED; i++) {
+        lok(tracked[i] == NULL);
+    }
+}
+
+void comment_events() {
+    const char* data =
+        "-- head\n"
+        "key --[[ mid ]] = { 1, -- one\n"
+        "  2 } -- tail\n";
+    const ELTN_Event expected[] = {
+        ELTN_COMMENT, ELTN_DEF_NAME, ELTN_COMMENT, ELTN_TABLE_START,
+        ELTN_VALUE_INTEGER, ELTN_COMMENT, ELTN_VALUE_INTEGER,
+        ELTN_TABLE_END, ELTN_COMMENT, ELTN_STREAM_END
+    };
+    const char* comments[] = { "-- head\n", "--[[ mid ]]", "-- one\n",
+        "-- tail\n"
+    };
+    const size_t pieces[] = { 0, 1, 3 };
+
+    for (int i = 0; i < sizeof(pieces) / sizeof(pieces[0]); i++) {
+        ELTN_Parser* parser = ELTN_Parser_new();
+        ELTN_Buffer* buffer = ELTN_Parser_buffer(parser);
+        size_t written = 0;
+        int ncomments = 0;
+
+        ELTN_Parser_set_include_comments(parser, true);
+        lok(ELTN_Parser_include_comments(parser));
+        if (pieces[i] == 0) {
+            read_string(parser, data);
+        } else {
+            ELTN_Parser_set_incremental(parser, true);
+        }
+
+        for (int j = 0; j < sizeof(expected) / sizeof(expected[0]); j++) {
+            ELTN_Parser_next(parser);
+            while (ELTN_Parser_event(parser) == ELTN_NEED_MORE_INPUT) {
+                size_t n = (strlen(data) - written < pieces[i])
+                    ? strlen(data) - written : pieces[i];
+
+                if (n == 0) {
+                    ELTN_Buffer_close(buffer);
+                } else {
+                    ELTN_Buffer_write(buffer, data + written, n);
+                    written += n;
+                }
+                ELTN_Parser_next(parser);
+            }
+            lequal(expected[j], ELTN_Parser_event(parser));
+            if (ELTN_Parser_event(parser) == ELTN_COMMENT && ncomments < 4) {
+                assert_text_equal(parser, comments[ncomments]);
+                ncomments++;
+            } else if (ELTN_Parser_event(parser) == ELTN_DEF_NAME) {
+                assert_string_equal(parser, "key");
+            } else if (ELTN_Parser_event(parser) == ELTN_VALUE_INTEGER) {
+                lequal(ncomments == 2 ? 1 : 2,
+                       (int)ELTN_Parser_integer(parser));
+            }
+        }
+        lequal(4, ncomments);
+        ELTN_Parser_free(parser);
+    }
+
+    /*
+     * Without comments, the same document has no comment events.
+     */
+    ELTN_Parser* parser = ELTN_Parser_new();
+
+    read_string(parser, data);
+    while (ELTN_Parser_has_next(parser)) {
+        ELTN_Parser_next(parser);
+        lok(ELTN_Parser_event(parser) != ELTN_COMMENT);
+    }
+    lequal(ELTN_STREAM_END, ELTN_Parser_event(parser));
+    ELTN_Parser_free(parser);
+}
+
+void lazy_strings() {
+    ELTN_Parser* parser = ELTN_Parser_new();
+
+    read_string(parser,
+                "{ [\"a\\tb\"] = 'c\\nd', skipped = \"e\\x41\", "
+                "[[long]] }");
+
+    ELTN_Parser_next(parser);
+    lequal(ELTN_TABLE_START, ELTN_Parser_event(parser));
+
+    /*
+     * The key's value outlives the lookahead for its "]".
+     */
+    ELTN_Parser_next(parser);
+    lequal(ELTN_KEY_STRING, ELTN_Parser_event(parser));
+    assert_text_equal(parser, "\"a\\tb\"");
+    assert_string_equal(parser, "a\tb");
+    assert_string_equal(parser, "a\tb");
+
+    ELTN_Parser_next(parser);
+    lequal(ELTN_VALUE_STRING, ELTN_Parser_event(parser));
+    assert_string_equal(parser, "c\nd");
+
+    /*
+     * Values never asked for are never decoded.
+     */
+    ELTN_Parser_next(parser);
+    lequal(ELTN_KEY_STRING, ELTN_Parser_event(parser));
+    ELTN_Parser_next(parser);
+    lequal(ELTN_VALUE_STRING, ELTN_Parser_event(parser));
+    ELTN_Parser_next(parser);
+    lequal(ELTN_VALUE_STRING, ELTN_Parser_event(parser));
+    assert_text_equal(parser, "[[long]]");
+
+    ELTN_Parser_next(parser);
+    lequal(ELTN_TABLE_END, ELTN_Parser_event(parser));
+    assert_string_equal(parser, "}");
+
+    ELTN_Parser_free(parser);
+}
+
+void string_views() {
+    ELTN_Parser* parser = ELTN_Parser_new();
+    const char* str = NULL;
+    size_t len = 0;
+    char buf[8];
+
+    read_string(parser, "key = 'a\\tbcdefghij'");
+
+    ELTN_Parser_next(parser);
+    lequal(ELTN_DEF_NAME, ELTN_Parser_event(parser));
+    ELTN_Parser_text_view(parser, &str, &len);
+    lequal(3, (int)len);
+    lok(strncmp(str, "key", 3) == 0);
+    ELTN_Parser_string_view(parser, &str, &len);
+    lequal(3, (int)len);
+    lok(strncmp(str, "key", 3) == 0);
+    lequal(3, (int)ELTN_Parser_string_copy_into(parser, buf, sizeof(buf)));
+    lsequal("key", buf);
+
+    ELTN_Parser_next(parser);
+    lequal(ELTN_VALUE_STRING, ELTN_Parser_event(parser));
+    ELTN_Parser_text_view(parser, &str, &len);
+    lequal(14, (int)len);
+    lok(strncmp(str, "'a\\tbcdefghij'", 14) == 0);
+    ELTN_Parser_string_view(parser, &str, &len);
+    lequal(11, (int)len);
+    lok(strncmp(str, "a\tbcdefghij", 11) == 0);
+
+    /*
+     * Copies are truncated to fit, and null-terminated if there's room.
+     */
+    memset(buf, 'X', sizeof(buf));
+    lequal(11, (int)ELTN_Parser_string_copy_into(parser, buf, sizeof(buf)));
+    lok(strncmp(buf, "a\tbcdefg", sizeof(buf)) == 0);
+    lequal(14, (int)ELTN_Parser_text_copy_into(parser, buf, 4));
+    lok(strncmp(buf, "'a\\tdefg", sizeof(buf)) == 0);
+    lequal(11, (int)ELTN_Parser_string_copy_into(parser, NULL, 0));
+
+    ELTN_Parser_next(parser);
+    lequal(ELTN_STREAM_END, ELTN_Parser_event(parser));
+    ELTN_Parser_free(parser);
+}
+
+void interned_keys() {
+    ELTN_Parser* parser = ELTN_Parser_new();
+    const char* str = NULL;
+    size_t len = 0;
+    int name_id;
+
+    lok(!ELTN_Parser_intern_keys(parser));
+    len = 99;
+    ELTN_Parser_interned_key(parser, 0, &str, &len);
+    lok(str == NULL);
+    lequal(0, (int)len);
+
+    name_id = ELTN_Parser_intern_key(parser, "name", 4);
+    lequal(0, name_id);
+    lequal(1, ELTN_Parser_intern_key(parser, "size", 4));
+    lequal(0, ELTN_Parser_intern_key(parser, "name", 4));
+
+    read_string(parser, "obj = { name = 'x', ['name'] = 1, other = 2 }");
+
+    ELTN_Parser_next(parser);
+    lequal(ELTN_DEF_NAME, ELTN_Parser_event(parser));
+    lequal(-1, ELTN_Parser_key_id(parser));
+
+    ELTN_Parser_next(parser);
+    lequal(ELTN_TABLE_START, ELTN_Parser_event(parser));
+    lequal(-1, ELTN_Parser_key_id(parser));
+
+    ELTN_Parser_next(parser);
+    lequal(ELTN_KEY_STRING, ELTN_Parser_event(parser));
+    lequal(name_id, ELTN_Parser_key_id(parser));
+    ELTN_Parser_string_view(parser, &str, &len);
+    lequal(4, (int)len);
+    lsequal("name", str);
+
+    ELTN_Parser_next(parser);
+    lequal(ELTN_VALUE_STRING, ELTN_Parser_event(parser));
+    lequal(-1, ELTN_Parser_key_id(parser));
+
+    /*
+     * A quoted key has the same ID as the bare name.
+     */
+    ELTN_Parser_next(parser);
+    lequal(ELTN_KEY_STRING, ELTN_Parser_event(parser));
+    lequal(name_id, ELTN_Parser_key_id(parser));
+    ELTN_Parser_text_view(parser, &str, &len);
+    lequal(6, (int)len);
+    lok(strncmp(str, "'name'", 6) == 0);
+
+    ELTN_Parser_next(parser);
+    lequal(ELTN_VALUE_INTEGER, ELTN_Parser_event(parser));
+
+    ELTN_Parser_next(parser);
+    lequal(ELTN_KEY_STRING, ELTN_Parser_event(parser));
+    lequal(-1, ELTN_Parser_key_id(parser));
+    ELTN_Parser_string_view(parser, &str, &len);
+    lok(strncmp(str, "other", 5) == 0);
+
+    ELTN_Parser_interned_key(parser, 1, &str, &len);
+    lsequal("size", str);
+    len = 99;
+    ELTN_Parser_interned_key(parser, 2, &str, &len);
+    lok(str == NULL);
+    lequal(0, (int)len);
+    len = 99;
+    ELTN_Parser_interned_key(parser, -1, &str, &len);
+    lok(str == NULL);
+    lequal(0, (int)len);
+
+    ELTN_Parser_free(parser);
+}
+
+void intern_all_keys() {
+    ELTN_Parser* parser = ELTN_Parser_new();
+    const char* str = NULL;
+    size_t len = 0;
+    int ids[4];
+    int n = 0;
+
+    ELTN_Parser_set_intern_keys(parser, true);
+    lok(ELTN_Parser_intern_keys(parser));
+
+    read_string(parser, "a = { b = 1, [\"c\\x41\"] = 2 }\nb = 3\n");
+
+    while (ELTN_Parser_has_next(parser)) {
+        ELTN_Parser_next(parser);
+        switch (ELTN_Parser_event(parser)) {
+        case ELTN_DEF_NAME:
+        case ELTN_KEY_STRING:
+            if (n < 4) {
+                ids[n] = ELTN_Parser_key_id(parser);
+            }
+            n++;
+            break;
+        default:
+            lequal(-1, ELTN_Parser_key_id(parser));
+            break;
+        }
+    }
+    lequal(ELTN_STREAM_END, ELTN_Parser_event(parser));
+    lequal(4, n);
+    lequal(0, ids[0]);
+    lequal(1, ids[1]);
+    lequal(2, ids[2]);
+    lequal(1, ids[3]);
+
+    ELTN_Parser_interned_key(parser, 2, &str, &len);
+    lequal(2, (int)len);
+    lsequal("cA", str);
+
+    ELTN_Parser_free(parser);
+}
+
+void key_hashes() {
+    ELTN_Parser* parser = ELTN_Parser_new();
+    const uint64_t seed = 0x1234;
+
+    lok(ELTN_Parser_hash_seed(parser) == 0);
+    ELTN_Parser_set_hash_seed(parser, seed);
+    lok(ELTN_Parser_hash_seed(parser) == seed);
+
+    read_string(parser, "name = { [\"na\\x6De\"] = 1, [2] = 'name' }");
+
+    ELTN_Parser_next(parser);
+    lequal(ELTN_DEF_NAME, ELTN_Parser_event(parser));
+    lok(ELTN_Parser_key_hash(parser) == ELTN_hash("name", 4, seed));
+
+    ELTN_Parser_next(parser);
+    lequal(ELTN_TABLE_START, ELTN_Parser_event(parser));
+    lok(ELTN_Parser_key_hash(parser) == 0);
+
+    /*
+     * The hash is of the key's value, not its text.
+     */
+    ELTN_Parser_next(parser);
+    lequal(ELTN_KEY_STRING, ELTN_Parser_event(parser));
+    lok(ELTN_Parser_key_hash(parser) == ELTN_hash("name", 4, seed));
+
+    ELTN_Parser_next(parser);
+    lequal(ELTN_VALUE_INTEGER, ELTN_Parser_event(parser));
+    lok(ELTN_Parser_key_hash(parser) == 0);
+
+    ELTN_Parser_next(parser);
+    lequal(ELTN_KEY_INTEGER, ELTN_Parser_event(parser));
+    lok(ELTN_Parser_key_hash(parser) == 0);
+
+    ELTN_Parser_next(parser);
+    lequal(ELTN_VALUE_STRING, ELTN_Parser_event(parser));
+    lok(ELTN_Parser_key_hash(parser) == 0);
+
+    ELTN_Parser_free(parser);
+}
+
+void interned_key_hashes() {
+    ELTN_Parser* parser = ELTN_Parser_new();
+
+    lequal(0, ELTN_Parser_intern_key(parser, "name", 4));
+    ELTN_Parser_set_hash_seed(parser, 99);
+    ELTN_Parser_set_intern_keys(parser, true);
+
+    read_string(parser, "name = 1\nsize = 2\n");
+
+    ELTN_Parser_next(parser);
+    lequal(ELTN_DEF_NAME, ELTN_Parser_event(parser));
+    lequal(0, ELTN_Parser_key_id(parser));
+    lok(ELTN_Parser_key_hash(parser) == ELTN_hash("name", 4, 99));
+
+    ELTN_Parser_next(parser);
+    ELTN_Parser_next(parser);
+    lequal(ELTN_DEF_NAME, ELTN_Parser_event(parser));
+    lequal(1, ELTN_Parser_key_id(parser));
+    lok(ELTN_Parser_key_hash(parser) == ELTN_hash("size", 4, 99));
+
+    ELTN_Parser_free(parser);
+}
+
+void threaded_document() {
+    const char* data =
+        "key1 = { flag = true, number = 22, string = \"foo\" }\n"
+        "key2 = { flag = false, number = 0x20, string = 'bar' }\n";
+    ELTN_Parser* parser = ELTN_Parser_new();
+    ELTN_Buffer* buffer = ELTN_Parser_buffer(parser);
+    Writer_Thread writer = { buffer, data };
+    pthread_t thread;
+    int nevents = 0;
+
+    lok(ELTN_Buffer_set_max_capacity(buffer, 8));
+    lok(ELTN_Buffer_set_synchronized(buffer, true));
+    lequal(0, pthread_create(&thread, NULL, Writer_Thread_run, &writer));
+
+    while (ELTN_Parser_has_next(parser)) {
+        ELTN_Parser_next(parser);
+        nevents++;
+    }
+    pthread_join(thread, NULL);
+
+    lequal(ELTN_STREAM_END, ELTN_Parser_event(parser));
+    lequal(19, nevents);
+    lequal(8, (int)ELTN_Buffer_capacity(buffer));
+
+    ELTN_Parser_free(parser);
+}
+
+void threaded_incremental_document() {
+    const char* data =
+        "key = { comment = 'a string much longer than the buffer' }\n";
+    ELTN_Parser* parser = ELTN_Parser_new();
+    ELTN_Buffer* buffer = ELTN_Parser_buffer(parser);
+    Writer_Thread writer = { buffer, data };
+    pthread_t thread;
+    int nevents = 0;
+
+    /*
+     * Synchronized buffers wait for input, so the parser must not hold
+     * on to a whole event that can't fit in them.
+     */
+    ELTN_Parser_set_incremental(parser, true);
+    lok(ELTN_Buffer_set_max_capacity(buffer, 8));
+    lok(ELTN_Buffer_set_synchronized(buffer, true));
+    lequal(0, pthread_create(&thread, NULL, Writer_Thread_run, &writer));
+
+    while (ELTN_Parser_has_next(parser)) {
+        ELTN_Parser_next(parser);
+        lok(ELTN_Parser_event(parser) != ELTN_NEED_MORE_INPUT);
+        nevents++;
+    }
+    pthread_join(thread, NULL);
+
+    lequal(ELTN_STREAM_END, ELTN_Parser_event(parser));
+    lequal(6, nevents);
+
+    ELTN_Parser_free(parser);
+}
+
 int main(int argc, char* argv[]) {
     lrun("test_empty_document", empty_document);
     lrun("test_empty_table", empty_table);
     lrun("test_single_definition", single_definition);
     lrun("test_simple_table", simple_table);
     lrun("test_complex_document", complex_document);
+    lrun("test_in_place_document", in_place_document);
+    lrun("test_read_path_document", read_path_document);
+    lrun("test_read_fd_pipe", read_fd_pipe);
+    lrun("test_read_path_missing", read_path_missing);
+    lrun("test_read_path_directory", read_path_directory);
+    lrun("test_read_lent_error", read_lent_error);
+    lrun("test_threaded_document", threaded_document);
+    lrun("test_threaded_incremental_document",
+         threaded_incremental_document);
+    lrun("test_limit_token_length", limit_token_length);
+    lrun("test_limit_depth", limit_depth);
+    lrun("test_limit_document_size", limit_document_size);
+    lrun("test_limit_buffer_capacity", limit_buffer_capacity);
+    lrun("test_incremental_document", incremental_document);
+    lrun("test_incremental_error", incremental_error);
+    lrun("test_incremental_error_position", incremental_error_position);
+    lrun("test_comment_events", comment_events);
+    lrun("test_comment_events_with_pool", comment_events_with_pool);
+    lrun("test_lazy_strings", lazy_strings);
+    lrun("test_string_views", string_views);
+    lrun("test_interned_keys", interned_keys);
+    lrun("test_intern_all_keys", intern_all_keys);
+    lrun("test_key_hashes", key_hashes);
+    lrun("test_interned_key_hashes", interned_key_hashes);
     lresults();
     return lfails != 0;
 }
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2025 Frank Mitchell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <string.h>
+#include "minctest.h"
+#include "escan.h"
+#include "estring.h"
+
+#define TEXT_SIZE 200
+
+static const ELTN_Scan_Level LEVELS[] = {
+    ELTN_SCAN_SCALAR, ELTN_SCAN_SSE2, ELTN_SCAN_AVX2
+};
+
+#define LEVELS_SIZE (sizeof(LEVELS) / sizeof(LEVELS[0]))
+
+void scan_level() {
+    const ELTN_Scan_Level best = ELTN_scan_level();
+
+    lequal(ELTN_SCAN_SCALAR, ELTN_scan_set_level(ELTN_SCAN_SCALAR));
+    lequal(ELTN_SCAN_SCALAR, ELTN_scan_level());
+    lok(ELTN_scan_set_level(ELTN_SCAN_AVX2) <= ELTN_SCAN_AVX2);
+    lequal(best, ELTN_scan_level());
+}
+
+/*
+ * Put each stop byte at each position in text of each length, and check
+ * that every level finds the first one.
+ */
+void scan_string_stop() {
+    const char stops[] = "'\"\\\r\n";
+    char8_t text[TEXT_SIZE];
+
+    for (int i = 0; i < LEVELS_SIZE; i++) {
+        ELTN_scan_set_level(LEVELS[i]);
+        for (const char* s = stops; *s != '\0'; s++) {
+            for (size_t pos = 0; pos < 70; pos++) {
+                memset(text, 'a', TEXT_SIZE);
+                text[pos] = *s;
+                text[pos + 1] = '\'';
+                lequal((int)pos,
+                       (int)(ELTN_scan_string_stop(text, text + TEXT_SIZE)
+                             - text));
+                lequal((int)pos,
+                       (int)(ELTN_scan_string_stop(text, text + pos) - text));
+            }
+        }
+        memset(text, 0xE9, TEXT_SIZE);
+        lequal(TEXT_SIZE,
+               (int)(ELTN_scan_string_stop(text, text + TEXT_SIZE) - text));
+        lok(ELTN_scan_string_stop(text + 5, text + 5) == text + 5);
+    }
+    ELTN_scan_set_level(ELTN_SCAN_AVX2);
+}
+
+void scan_non_blank() {
+    const char blanks[] = " \t\v\f\r";
+    char8_t text[TEXT_SIZE];
+
+    for (int i = 0; i < LEVELS_SIZE; i++) {
+        ELTN_scan_set_level(LEVELS[i]);
+        for (size_t pos = 0; pos < 70; pos++) {
+            for (size_t j = 0; j < TEXT_SIZE; j++) {
+                text[j] = blanks[j % (sizeof(blanks) - 1)];
+            }
+            text[pos] = (pos % 2) ? '\n' : 'x';
+            lequal((int)pos,
+                   (int)(ELTN_scan_non_blank(text, text + TEXT_SIZE) - text));
+            lequal((int)pos,
+                   (int)(ELTN_scan_non_blank(text, text + pos) - text));
+        }
+        memset(text, ' ', TEXT_SIZE);
+        lequal(TEXT_SIZE,
+               (int)(ELTN_scan_non_blank(text, text + TEXT_SIZE) - text));
+        text[TEXT_SIZE - 1] = 0x8D;     /* '\r' with the high bit set */
+        lequal(TEXT_SIZE - 1,
+               (int)(ELTN_scan_non_blank(text, text + TEXT_SIZE) - text));
+    }
+    ELTN_scan_set_level(ELTN_SCAN_AVX2);
+}
+
+void scan_line_end() {
+    const char8_t text[] = "-- comment\r\nnext";
+
+    lequal(11, (int)(ELTN_scan_line_end(text, text + 16) - text));
+    lequal(8, (int)(ELTN_scan_line_end(text, text + 8) - text));
+    lok(ELTN_scan_line_end(NULL, NULL) == NULL);
+}
+
+void scan_count_lines() {
+    char8_t text[TEXT_SIZE];
+    const char8_t* after;
+
+    for (int i = 0; i < LEVELS_SIZE; i++) {
+        ELTN_scan_set_level(LEVELS[i]);
+        for (size_t pos = 0; pos < 70; pos++) {
+            after = NULL;
+            memset(text, 'a', TEXT_SIZE);
+            text[pos] = '\n';
+            text[2 * pos + 1] = '\n';
+            lequal(2, (int)ELTN_scan_count_lines(text, text + TEXT_SIZE,
+                                                 &after));
+            lequal((int)(2 * pos + 2), (int)(after - text));
+
+            after = NULL;
+            lequal(1, (int)ELTN_scan_count_lines(text, text + pos + 1,
+                                                 &after));
+            lok(after == text + pos + 1);
+            lequal(0, (int)ELTN_scan_count_lines(text, text + pos, &after));
+            lok(after == text + pos + 1);
+        }
+        memset(text, '\n', TEXT_SIZE);
+        lequal(TEXT_SIZE - 3,
+               (int)ELTN_scan_count_lines(text + 3, text + TEXT_SIZE,
+                                          &after));
+        lok(after == text + TEXT_SIZE);
+    }
+    ELTN_scan_set_level(ELTN_SCAN_AVX2);
+}
+
+int main(int argc, char* argv[]) {
+    lrun("test_scan_level", scan_level);
+    lrun("test_scan_string_stop", scan_string_stop);
+    lrun("test_scan_non_blank", scan_non_blank);
+    lrun("test_scan_line_end", scan_line_end);
+    lrun("test_scan_count_lines", scan_count_lines);
+    lresults();
+    return lfails != 0;
+}
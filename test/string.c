@@ -102,6 +102,54 @@ void string_unicode_escapes() {
     lsequal(expect, str);
 }
 
+void string_escapes_between_runs() {
+    char* str;
+    size_t len;
+    const char* data = "\"\\u{E9}t\\u{E9} it's \\x41\\66\\x4g\\u{}\\\"\"";
+    const char* expect = "\u00E9t\u00E9 it's A64g{}\"";
+
+    ELTN_unescape_quoted_string(NULL, data, strlen(data), &str, &len);
+    lequal((int)strlen(expect), (int)len);
+    lsequal(expect, str);
+}
+
+void string_quoted_body() {
+    const char* body = NULL;
+    size_t len = 0;
+    const char* plain = "\"it's plain\"";
+    const char* escaped = "'it\\'s not'";
+
+    lok(ELTN_quoted_string_body(plain, strlen(plain), &body, &len));
+    lok(body == plain + 1);
+    lequal(10, (int)len);
+
+    lok(ELTN_quoted_string_body("''", 2, &body, &len));
+    lequal(0, (int)len);
+
+    lok(!ELTN_quoted_string_body(escaped, strlen(escaped), &body, &len));
+    lok(!ELTN_quoted_string_body("'open", 5, &body, &len));
+    lok(!ELTN_quoted_string_body("bare", 4, &body, &len));
+}
+
+void string_char_classes() {
+    int c;
+
+    for (c = 0; c < 256; c++) {
+        const bool digit = c >= '0' && c <= '9';
+        const bool letter = (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+        const bool space = c == ' ' || (c >= '\t' && c <= '\r');
+
+        lok(ELTN_is_digit(c) == digit);
+        lok(ELTN_is_space(c) == space);
+        lok(ELTN_is_name_start(c) == (letter || c == '_'));
+        lok(ELTN_is_name_part(c) == (letter || digit || c == '_'));
+        lok(ELTN_CHAR_IS(c, ELTN_CLASS_BLANK) == (space && c != '\n'));
+        lok(ELTN_CHAR_IS(c, ELTN_CLASS_STRING_STOP) ==
+            (c == '\'' || c == '"' || c == '\\' || c == '\r' || c == '\n'));
+    }
+    lok(!ELTN_is_name_part(0x100 + 'a'));
+}
+
 /*
  * TODO: test bad escape sequences and missing quotes.
  * TODO: test long strings.
@@ -116,6 +164,9 @@ int main(int argc, char* argv[]) {
     lrun("test_string_hex_escapes", string_hex_escapes);
     lrun("test_string_octal_escapes", string_octal_escapes);
     lrun("test_string_unicode_escapes", string_unicode_escapes);
+    lrun("test_string_escapes_between_runs", string_escapes_between_runs);
+    lrun("test_string_quoted_body", string_quoted_body);
+    lrun("test_string_char_classes", string_char_classes);
     lresults();
     return lfails != 0;
 }
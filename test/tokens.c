@@ -0,0 +1,135 @@
+/*
+ * Copyright 2025 Frank Mitchell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <string.h>
+#include "minctest.h"
+#include "eltn.h"
+
+#define MAX_TOKENS  16
+
+static const char DOC[] =
+    "-- settings\n"
+    "x = { 1, 2.5, 'a\\'b' }\r\n"
+    "[ [[long]] ] = nil;\n"
+    "y = @\n";
+
+static const ELTN_Token_Record EXPECTED[] = {
+    {ELTN_TOKEN_COMMENT, 0, 12},
+    {ELTN_TOKEN_NAME, 12, 1},
+    {ELTN_TOKEN_EQUALS, 14, 1},
+    {ELTN_TOKEN_CURLY_OPEN, 16, 1},
+    {ELTN_TOKEN_INTEGER, 18, 1},
+    {ELTN_TOKEN_COMMA, 19, 1},
+    {ELTN_TOKEN_NUMBER, 21, 3},
+    {ELTN_TOKEN_COMMA, 24, 1},
+    {ELTN_TOKEN_STRING, 26, 6},
+    {ELTN_TOKEN_CURLY_CLOSE, 33, 1},
+    {ELTN_TOKEN_SQUARE_OPEN, 36, 1},
+    {ELTN_TOKEN_LONG_STRING, 38, 8},
+    {ELTN_TOKEN_SQUARE_CLOSE, 47, 1},
+    {ELTN_TOKEN_EQUALS, 49, 1},
+    {ELTN_TOKEN_NIL, 51, 3},
+    {ELTN_TOKEN_SEMICOLON, 54, 1},
+    {ELTN_TOKEN_NAME, 56, 1},
+    {ELTN_TOKEN_EQUALS, 58, 1},
+    {ELTN_TOKEN_INVALID, 60, 1},
+    {ELTN_TOKEN_EOF, 62, 0}
+};
+
+static const size_t EXPECTED_COUNT =
+    sizeof(EXPECTED) / sizeof(ELTN_Token_Record);
+
+static void check_record(size_t i, ELTN_Token_Record* rec) {
+    lsequal(ELTN_Token_name(EXPECTED[i].type), ELTN_Token_name(rec->type));
+    lequal((int)EXPECTED[i].offset, (int)rec->offset);
+    lequal((int)EXPECTED[i].length, (int)rec->length);
+}
+
+void tokenize_all() {
+    ELTN_Token_Record tokens[2 * MAX_TOKENS];
+    size_t offset = 0;
+    ssize_t count;
+
+    count = ELTN_tokenize(DOC, strlen(DOC), &offset, tokens, 2 * MAX_TOKENS);
+
+    lequal((int)EXPECTED_COUNT, (int)count);
+    lequal((int)strlen(DOC), (int)offset);
+    for (size_t i = 0; i < EXPECTED_COUNT && i < count; i++) {
+        check_record(i, &tokens[i]);
+    }
+}
+
+void tokenize_batches() {
+    ELTN_Token_Record tokens[3];
+    size_t offset = 0;
+    size_t total = 0;
+    ssize_t count;
+    bool done = false;
+
+    while (!done && total < EXPECTED_COUNT) {
+        count = ELTN_tokenize(DOC, strlen(DOC), &offset, tokens, 3);
+        lok(count > 0);
+        if (count <= 0) {
+            break;
+        }
+        for (size_t i = 0; i < count; i++) {
+            check_record(total + i, &tokens[i]);
+            done = (tokens[i].type == ELTN_TOKEN_EOF);
+        }
+        total += count;
+    }
+    lequal((int)EXPECTED_COUNT, (int)total);
+    lok(done);
+}
+
+void tokenize_empty() {
+    ELTN_Token_Record tokens[MAX_TOKENS];
+
+    lequal(1, (int)ELTN_tokenize("", 0, NULL, tokens, MAX_TOKENS));
+    lequal(ELTN_TOKEN_EOF, tokens[0].type);
+    lequal(0, (int)tokens[0].offset);
+
+    lequal(1, (int)ELTN_tokenize("  \n\t", 4, NULL, tokens, MAX_TOKENS));
+    lequal(ELTN_TOKEN_EOF, tokens[0].type);
+    lequal(4, (int)tokens[0].offset);
+
+    lequal(0, (int)ELTN_tokenize("x", 1, NULL, tokens, 0));
+}
+
+void tokenize_bad_offset() {
+    ELTN_Token_Record tokens[MAX_TOKENS];
+    size_t offset = 5;
+
+    lok(ELTN_tokenize("x", 1, &offset, tokens, MAX_TOKENS) < 0);
+
+    offset = SIZE_MAX;
+    lok(ELTN_tokenize("x", 1, &offset, tokens, MAX_TOKENS) < 0);
+}
+
+int main(int argc, char* argv[]) {
+    lrun("test_tokenize_all", tokenize_all);
+    lrun("test_tokenize_batches", tokenize_batches);
+    lrun("test_tokenize_empty", tokenize_empty);
+    lrun("test_tokenize_bad_offset", tokenize_bad_offset);
+    lresults();
+    return lfails != 0;
+}